@@ -0,0 +1,245 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#include <iostream>
+#include <vector>
+#include <string>
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+#include "batch.hh"
+#include "graph.hh"
+#include "solver.hh"
+#include "parser.hh"
+#include "util.hh"
+#include "csr.hh"
+#include "global.hh"
+
+using namespace std;
+
+/* graphs in flight per thread before the reader waits for them */
+constexpr int PENDING_PER_THREAD = 64;
+
+template <typename F>
+int util::solve(const Solver<F> &s, Graph<F> &G, const Run_options &opt)
+{
+    if (opt.decide)
+        return (opt.brute)
+            ? s.shortest_even_cycle_brute(G) != -1
+            : s.has_even_cycle(G);
+    else
+        return (opt.brute)
+            ? s.shortest_even_cycle_brute(G)
+            : s.shortest_even_cycle(G);
+}
+
+/* a graph in flight. the results are printed in the order of the slots */
+struct Slot
+{
+    string name;
+    CSR adj;
+    uint64_t index;
+    int result;
+    atomic<bool> done;
+
+    Slot(const string &name, CSR adj, const uint64_t index):
+        name(name), adj(move(adj)), index(index), result(0), done(false) {}
+};
+
+template <typename F>
+class Batch
+{
+private:
+    const Run_options &opt;
+    const Solver<F> solver;
+    /* deque keeps the slots in place for the tasks */
+    deque<Slot> slots;
+    long graphs;
+    bool ok;
+
+    /* prints the results of the finished prefix of the slots */
+    void flush()
+    {
+        while (!this->slots.empty()
+               && this->slots.front().done.load(memory_order_acquire))
+        {
+            const Slot &slot = this->slots.front();
+            if (slot.result == FIELD_TOO_SMALL)
+            {
+                cout << "a component of " << slot.name << " has too many "
+                     << "vertices for the field, please a larger n" << endl;
+                this->ok = false;
+            }
+            else
+            {
+                cout << slot.name << " " << slot.result << "\n";
+            }
+            this->slots.pop_front();
+        }
+    }
+
+    void submit(const string &name, CSR adj)
+    {
+        this->slots.emplace_back(name, move(adj), this->graphs);
+        this->graphs++;
+        Slot *slot = &this->slots.back();
+
+        /* large graphs spawn more tasks in the solver. the solver draws
+         * its random values before them, so the generator of the thread
+         * is not reseeded by another graph in between */
+        #pragma omp task firstprivate(slot) depend(out: slot->result)
+        {
+            /* the result of each graph does not depend on the
+             * scheduling */
+            global::randgen.init(util::mix_seed(this->opt.seed, slot->index));
+            if (this->opt.direct)
+                slot->adj = util::direct_undirected(slot->adj);
+            Graph<F> G(move(slot->adj));
+            slot->result = util::solve(this->solver, G, this->opt);
+            slot->done.store(true, memory_order_release);
+        }
+
+        this->flush();
+        /* only the oldest graph is waited for, the rest keep the
+         * threads busy while the next graphs are read */
+        const uint pending = PENDING_PER_THREAD * omp_get_num_threads();
+        while (this->slots.size() >= pending)
+        {
+            /* runs the task itself if no thread has taken it yet */
+            #pragma omp taskwait depend(in: this->slots.front().result)
+            this->flush();
+        }
+    }
+
+    /* digraph6 or graph6 lines */
+    void read_stream(const int fd, const string &name)
+    {
+        Graph_reader reader(fd);
+        CSR adj;
+        long i = 0;
+        while (reader.next(adj))
+            this->submit(name + ":" + to_string(++i), move(adj));
+
+        if (!reader.get_error().empty())
+        {
+            cout << "invalid graph stream " << name << ", "
+                 << reader.get_error() << endl;
+            this->ok = false;
+        }
+    }
+
+    void read_file(const string &fname)
+    {
+        const int fd = open(fname.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            cout << "unable to open file: " << fname << endl;
+            this->ok = false;
+            return;
+        }
+
+        /* the nauty formats have a graph on each line */
+        char head[16];
+        const ssize_t r = pread(fd, head, sizeof(head), 0);
+        const Graph_format format = util::detect_format(head, head + max(r, 0l));
+        if (format == DIGRAPH6 || format == GRAPH6)
+        {
+            this->read_stream(fd, fname);
+            close(fd);
+            return;
+        }
+        close(fd);
+
+        CSR adj;
+        if (!util::parse_file(fname, adj))
+        {
+            this->ok = false;
+            return;
+        }
+        this->submit(fname, move(adj));
+    }
+
+    /* the regular files in the directory ordered by name */
+    void read_directory(const string &dname)
+    {
+        DIR *dir = opendir(dname.c_str());
+        if (!dir)
+        {
+            cout << "unable to open directory: " << dname << endl;
+            this->ok = false;
+            return;
+        }
+
+        vector<string> files;
+        struct stat st;
+        for (struct dirent *e = readdir(dir); e; e = readdir(dir))
+        {
+            const string path = dname + "/" + e->d_name;
+            if (e->d_name[0] != '.' && stat(path.c_str(), &st) == 0
+                && S_ISREG(st.st_mode))
+                files.push_back(path);
+        }
+        closedir(dir);
+        sort(files.begin(), files.end());
+
+        for (uint i = 0; i < files.size() && this->ok; i++)
+            this->read_file(files[i]);
+    }
+
+public:
+    explicit Batch(const Run_options &opt): opt(opt), graphs(0), ok(true) {}
+
+    long run(const vector<string> &sources)
+    {
+        #pragma omp parallel
+        #pragma omp single
+        {
+            for (uint i = 0; i < sources.size() && this->ok; i++)
+            {
+                struct stat st;
+                if (sources[i] == "-")
+                    this->read_stream(STDIN_FILENO, sources[i]);
+                else if (stat(sources[i].c_str(), &st) == 0
+                         && S_ISDIR(st.st_mode))
+                    this->read_directory(sources[i]);
+                else
+                    this->read_file(sources[i]);
+            }
+
+            #pragma omp taskwait
+            this->flush();
+        }
+        cout.flush();
+
+        return (this->ok) ? this->graphs : -1;
+    }
+};
+
+template <typename F>
+long util::solve_batch(const vector<string> &sources, const Run_options &opt)
+{
+    Batch<F> batch(opt);
+    return batch.run(sources);
+}
+
+template int util::solve(const Solver<GF2_16> &,
+                         Graph<GF2_16> &,
+                         const Run_options &);
+template long util::solve_batch<GF2_16>(const vector<string> &,
+                                        const Run_options &);
+
+template int util::solve(const Solver<GF2_32> &,
+                         Graph<GF2_32> &,
+                         const Run_options &);
+template long util::solve_batch<GF2_32>(const vector<string> &,
+                                        const Run_options &);
+
+template int util::solve(const Solver<GF2_generic> &,
+                         Graph<GF2_generic> &,
+                         const Run_options &);
+template long util::solve_batch<GF2_generic>(const vector<string> &,
+                                             const Run_options &);
@@ -0,0 +1,44 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+
+#include "graph.hh"
+#include "solver.hh"
+
+/* what is computed for each graph */
+struct Run_options
+{
+    /* brute force solver */
+    bool brute = false;
+    /* only decide if there is an even cycle, 1 or 0 */
+    bool decide = false;
+    /* direct the undirected input graph */
+    bool direct = false;
+    /* the batch mode seeds the generator of each graph with
+     * this and the index of the graph */
+    uint64_t seed = 0;
+};
+
+namespace util
+{
+    /* the shortest even cycle of G, -1 if there is none,
+     * or 1 and 0 with decide */
+    template <typename F>
+    int solve(const Solver<F> &s, Graph<F> &G, const Run_options &opt);
+
+    /* solves every graph of the sources and prints "<name> <result>"
+     * lines in the input order. a source is a graph file, a directory
+     * of them or - for stdin. digraph6 and graph6 files and stdin are
+     * streams of graphs, one per line, named <source>:<index>. one
+     * thread reads the graphs and prints the results while the rest
+     * solve them, each graph as a task. returns the number of graphs
+     * solved, -1 on errors. the graphs are solved over the field F */
+    template <typename F>
+    long solve_batch(const std::vector<std::string> &sources,
+                     const Run_options &opt);
+}
+
+#endif
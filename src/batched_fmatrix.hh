@@ -0,0 +1,174 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#ifndef B_FMATRIX_H
+#define B_FMATRIX_H
+
+#include <vector>
+#include <immintrin.h>
+
+#include "gf.hh"
+#include "global.hh"
+#include "fmatrix.hh"
+#include "packed_fmatrix.hh"
+
+/* determinants of the gamma multiplied matrices in pdet.
+ * each lane is the same matrix evaluated at a different gamma,
+ * so one elimination gives VECTOR_N determinants. pivots are
+ * searched for each lane separately and rows are swapped with
+ * blends. W is one of the packed multiplications in packed_fmatrix.hh
+ * for the field F */
+template <typename F, typename W>
+class Batched_FMatrix
+{
+private:
+    static constexpr int VECTOR_N = W::VECTOR_N;
+
+    int n;
+    int r1;
+    int r2;
+    std::vector<long4_t> m;
+    /* every element broadcast to all lanes */
+    std::vector<long4_t> base;
+    /* gamma^i in each lane */
+    std::vector<long4_t> powers;
+
+    const long4_t &get(const int row, const int col) const
+    {
+        return this->m[row*this->n + col];
+    }
+
+    void set(const int row, const int col, const long4_t &v)
+    {
+        this->m[row*this->n + col] = v;
+    }
+
+    /* swap rows r1 and r2 in the lanes of mask, starting from column idx */
+    inline void swap_rows(const int r1,
+                          const int r2,
+                          const int idx,
+                          const long4_t &mask
+    )
+    {
+        for (int col = idx; col < this->n; col++)
+        {
+            const long4_t a = this->get(r1, col);
+            const long4_t b = this->get(r2, col);
+            this->set(r1, col, _mm256_blendv_epi8(a, b, mask));
+            this->set(r2, col, _mm256_blendv_epi8(b, a, mask));
+        }
+    }
+
+    /* subtract v times r1 from r2, starting from column idx */
+    inline void row_op(const int r1,
+                       const int r2,
+                       const int idx,
+                       const long4_t &v
+    )
+    {
+        for (int col = idx; col < this->n; col++)
+            this->set(r2, col,
+                      _mm256_xor_si256(
+                          this->get(r2, col),
+                          W::mul(this->get(r1, col), v)
+                      )
+            );
+    }
+
+public:
+    Batched_FMatrix(const FMatrix<F> &matrix, const int r1, const int r2)
+    {
+        this->n = matrix.get_n();
+        this->r1 = r1;
+        this->r2 = r2;
+
+        this->m.resize(this->n * this->n);
+        this->base.resize(this->n * this->n);
+        this->powers.resize(this->n);
+
+        for (int row = 0; row < this->n; row++)
+            for (int col = 0; col < this->n; col++)
+                this->base[row*this->n + col] =
+                    Lanes<W>::broadcast(matrix(row, col).get_repr());
+    }
+
+    /* copies the matrix and multiplies rows r1 and r2 with the
+     * powers of gamma[i] in lane i */
+    void init(const GF_element<F> *gamma)
+    {
+        for (int i = 0; i < this->n * this->n; i++)
+            this->m[i] = this->base[i];
+
+        uint64_t elems[VECTOR_N];
+        for (int i = 0; i < VECTOR_N; i++)
+            elems[i] = gamma[i].get_repr();
+        const long4_t pac_gamma = Lanes<W>::pack(elems);
+
+        this->powers[0] = Lanes<W>::broadcast(0x1);
+        for (int i = 1; i < this->n; i++)
+            this->powers[i] = W::mul(this->powers[i - 1], pac_gamma);
+
+        for (int col = 0; col < this->n; col++)
+        {
+            this->set(this->r1, col, W::mul(
+                          this->get(this->r1, col),
+                          this->powers[col]));
+            this->set(this->r2, col, W::mul(
+                          this->get(this->r2, col),
+                          this->powers[this->n - 1 - col]));
+        }
+    }
+
+    /* determinants of each lane to delta */
+    void det(GF_element<F> *delta)
+    {
+        long4_t det = Lanes<W>::broadcast(0x1);
+        /* lanes where a column had no pivot */
+        long4_t singular = _mm256_setzero_si256();
+        uint64_t elems[VECTOR_N];
+
+        for (int col = 0; col < this->n; col++)
+        {
+            long4_t missing = Lanes<W>::zero_lanes(this->get(col, col));
+            for (int row = col + 1;
+                 row < this->n && !_mm256_testz_si256(missing, missing);
+                 row++)
+            {
+                /* lanes that are still missing a pivot and have one here */
+                const long4_t found = _mm256_andnot_si256(
+                    Lanes<W>::zero_lanes(this->get(row, col)),
+                    missing
+                );
+                if (_mm256_testz_si256(found, found))
+                    continue;
+                this->swap_rows(col, row, col, found);
+                missing = _mm256_andnot_si256(found, missing);
+            }
+
+            /* continue singular lanes with pivot one, they are zeroed
+             * at the end */
+            singular = _mm256_or_si256(singular, missing);
+            const long4_t pivot = _mm256_blendv_epi8(
+                this->get(col, col),
+                Lanes<W>::broadcast(0x1),
+                missing
+            );
+            det = W::mul(det, pivot);
+
+            const long4_t inv = Lanes<W>::inv(pivot);
+
+            util::for_rows(col + 1, this->n, [&](const int row)
+            {
+                const long4_t v = W::mul(this->get(row, col), inv);
+                this->row_op(col, row, col + 1, v);
+            });
+        }
+
+        det = _mm256_andnot_si256(singular, det);
+        Lanes<W>::unpack(det, elems);
+        for (int i = 0; i < VECTOR_N; i++)
+            delta[i] = GF_element<F>(elems[i]);
+    }
+
+    static constexpr int lanes() { return VECTOR_N; }
+};
+
+#endif
@@ -0,0 +1,77 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include <cstring>
+
+#include "csr.hh"
+#include "parser.hh"
+
+using namespace std;
+
+int main(const int argc, char **argv)
+{
+    if (argc == 1 || (argc == 2 && strcmp(argv[1], "--help") == 0))
+    {
+        cout << "Usage: digraph-convert [-l | -e | -d | -g | -m] <input> <output>" << endl;
+        cout << endl;
+        cout << "Converts a graph file to the binary format read by digraph -f." << endl;
+        cout << "Without an option the format is detected, except for edge lists." << endl;
+        cout << endl;
+        cout << "Options:" << endl;
+        cout << " -l\t line per vertex syntax explained in readme.md" << endl;
+        cout << " -e\t edge list, one arc \"u v\" per line" << endl;
+        cout << " -d\t digraph6, the first graph of the file" << endl;
+        cout << " -g\t graph6, the first graph of the file" << endl;
+        cout << " -m\t DIMACS with \"a u v\" arcs or \"e u v\" edges" << endl;
+        cout << " --help\t display usage information" << endl;
+        cout << endl;
+        return 0;
+    }
+
+    int opt;
+    Graph_format format = AUTO;
+
+    while ((opt = getopt(argc, argv, "ledgm")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            format = LINES;
+            break;
+        case 'e':
+            format = EDGE_LIST;
+            break;
+        case 'd':
+            format = DIGRAPH6;
+            break;
+        case 'g':
+            format = GRAPH6;
+            break;
+        case 'm':
+            format = DIMACS;
+            break;
+        case '?':
+            cout << "call with no arguments for help" << endl;
+            return -1;
+        }
+    }
+
+    if (argc - optind != 2)
+    {
+        cout << "an input and an output file are mandatory!" << endl;
+        return -1;
+    }
+
+    CSR adj;
+    if (!util::parse_file(argv[optind], adj, format))
+        return -1;
+
+    if (!util::write_binary(argv[optind + 1], adj))
+        return -1;
+
+    cout << "wrote graph of " << adj.get_n() << " vertices and "
+         << adj.get_m() << " arcs to " << argv[optind + 1] << endl;
+
+    return 0;
+}
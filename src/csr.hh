@@ -0,0 +1,53 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#ifndef CSR_H
+#define CSR_H
+
+#include <vector>
+
+/* compressed sparse rows. the out-neighbours of v are
+ * targets[offsets[v]], .., targets[offsets[v+1] - 1] */
+struct CSR
+{
+    std::vector<int> offsets;
+    std::vector<int> targets;
+
+    CSR(): offsets(1, 0) {}
+
+    explicit CSR(const std::vector<std::vector<int>> &adj):
+        offsets(adj.size() + 1, 0)
+    {
+        for (unsigned int v = 0; v < adj.size(); v++)
+            this->offsets[v + 1] = this->offsets[v] + adj[v].size();
+
+        this->targets.reserve(this->offsets.back());
+        for (unsigned int v = 0; v < adj.size(); v++)
+            this->targets.insert(this->targets.end(), adj[v].begin(), adj[v].end());
+    }
+
+    inline int get_n() const { return this->offsets.size() - 1; }
+
+    inline int get_m() const { return this->targets.size(); }
+
+    inline int degree(const int v) const
+    {
+        return this->offsets[v + 1] - this->offsets[v];
+    }
+
+    /* i:th out-neighbour of v */
+    inline int operator()(const int v, const int i) const
+    {
+        return this->targets[this->offsets[v] + i];
+    }
+
+    inline const int *begin(const int v) const
+    {
+        return this->targets.data() + this->offsets[v];
+    }
+
+    inline const int *end(const int v) const
+    {
+        return this->targets.data() + this->offsets[v + 1];
+    }
+};
+
+#endif
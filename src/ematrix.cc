@@ -1,31 +1,104 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <valarray>
+#include <vector>
 #include <list>
+#include <memory>
+#include <type_traits>
 
 #include "polynomial.hh"
 #include "global.hh"
 #include "ematrix.hh"
 #include "fmatrix.hh"
+#include "lane_fmatrix.hh"
+#include "row_override.hh"
 #include "gf.hh"
 
 using namespace std;
 
-Polynomial EMatrix::project_pdet(const int i1, const int i2) const
+/* smaller matrices compute the permanents in row_op_per
+ * without tasks */
+constexpr int PER_TASK_THRESHOLD = 8;
+
+/* sum of the low sums of minors[0..count-1] with VECTOR_N of them in
+ * each Lane_FMatrix. the batches are independent tasks */
+template <typename F, typename W>
+static GF_element<F> lane_low_sum(const vector<Row_override<F>> &minors,
+                                  const unsigned int count
+)
+{
+    constexpr int LANES = Lane_FMatrix<F, W>::lanes();
+    const unsigned int batches = (count + LANES - 1) / LANES;
+    vector<GF_element<F>> sum(batches);
+
+    #pragma omp taskloop grainsize(1) shared(minors, sum) \
+        if(minors[0].get_n() >= PER_TASK_THRESHOLD)
+    for (unsigned int b = 0; b < batches; b++)
+    {
+        GF_element<F> s[LANES];
+        Lane_FMatrix<F, W> L(minors, b * LANES);
+        L.pdet_low_sums(s);
+        sum[b] = util::GF_zero<F>();
+        for (unsigned int i = b * LANES; i < (b + 1) * LANES && i < count; i++)
+            sum[b] += s[i - b * LANES];
+    }
+
+    GF_element<F> acc = util::GF_zero<F>();
+    for (unsigned int b = 0; b < batches; b++)
+        acc += sum[b];
+    return acc;
+}
+
+/* sum of the low sums of the minors and removes them. unless all is set,
+ * only full vectors of them are computed and the rest are left for later */
+template <typename F>
+static GF_element<F> low_sum(vector<Row_override<F>> &minors, const bool all)
 {
-    FMatrix m(this->get_n());
+    const int lanes = (F::get_n() <= 16) ? Wide_n::VECTOR_N
+        : Wide_n_64::VECTOR_N;
+    const unsigned int count = (all) ? minors.size()
+        : minors.size() - minors.size() % lanes;
+    if (count == 0)
+        return util::GF_zero<F>();
+
+    GF_element<F> sum;
+    if constexpr (is_same_v<F, GF2_16>)
+        sum = lane_low_sum<F, Wide_16>(minors, count);
+    else if constexpr (is_same_v<F, GF2_32>)
+        sum = lane_low_sum<F, Wide_32>(minors, count);
+    else if (F::get_n() < 16)
+        sum = lane_low_sum<F, Wide_n>(minors, count);
+    else
+        sum = lane_low_sum<F, Wide_n_64>(minors, count);
+
+    minors.erase(minors.begin(), minors.begin() + count);
+    return sum;
+}
+
+template <typename F>
+FMatrix<F> EMatrix<F>::project() const
+{
+    FMatrix<F> m(this->get_n());
 
     for (int row = 0; row < this->get_n(); row++)
         for (int col = 0; col < this->get_n(); col++)
             m.set(row, col, this->operator()(row, col).project());
 
-    return m.pdet(i1, i2);
+    return m;
 }
 
 /* returns Per(this) - Det(this) as described in chapter 3
  * of the paper*/
-GR_element EMatrix::per_m_det()
+template <typename F>
+GR_element<typename F::Ring> EMatrix<F>::per_m_det()
 {
-    GR_element acc = util::GR_zero();
+    typedef typename F::Ring R;
+    GR_element<R> acc = util::GR_zero<R>();
+    /* the projections of the M'' of row_op_per left to compute. they
+     * fill the lanes of Lane_FMatrix across the columns */
+    vector<Row_override<F>> minors;
+    /* projection of this, kept up to date by row_op_per */
+    shared_ptr<FMatrix<F>> P = make_shared<FMatrix<F>>(this->project());
+    GF_element<F> low = util::GF_zero<F>();
     /* marked rows */
     valarray<bool> rows(false, this->get_n());
     /* odd elements at (odd[i], i). if odd[i] = -1 then
@@ -44,7 +117,7 @@ GR_element EMatrix::per_m_det()
             /* transpose? */
             if (!this->operator()(i1, j).is_even())
             {
-                acc += this->row_op_per(i1, j);
+                low += this->row_op_per(i1, j, P, minors);
                 rows[i1] = true;
                 odd[j] = i1;
                 break;
@@ -57,7 +130,11 @@ GR_element EMatrix::per_m_det()
         }
     }
 
-    GR_element det = util::GR_zero();
+    /* see per_similar, 2*lift is additive */
+    low += low_sum(minors, true);
+    acc += low.lift() + low.lift();
+
+    GR_element<R> det = util::GR_zero<R>();
     /* if more than two unmarked columns, det and per
      * of the final matrix is zero because in characteristic
      * 2 even*even = 0 */
@@ -78,25 +155,30 @@ GR_element EMatrix::per_m_det()
         /* permanent is the product of the odd and maybe
          * one even element at the crossing of unmarked row
          * and column */
+        GR_element<R> per = util::GR_one<R>();
+        for (int col = 0; col < (int) odd.size(); col++)
+            per *= this->operator()(odd[col], col);
+        acc += per;
+
+        /* permutation sign, a cycle of length l has l - 1 swaps */
         int swaps = 0;
-        valarray<bool> swapped(false, this->get_n());
-        GR_element per = util::GR_one();
+        valarray<bool> visited(false, this->get_n());
         for (int col = 0; col < (int) odd.size(); col++)
         {
-            const int row = odd[col];
-            per *= this->operator()(row, col);
-            /* works? */
-            if (row != col)
-                swaps++;
+            if (visited[col])
+                continue;
+            int len = 0;
+            for (int c = col; !visited[c]; c = odd[c])
+            {
+                visited[c] = true;
+                len++;
+            }
+            swaps += len - 1;
         }
-        acc += per;
-        /* each swap gets registered twice, thus divide by two */
-        swaps /= 2;
-        /* permutation sign */
         /* can just skip this and not just add per to acc */
         if (swaps % 2 == 1)
             /* unary - ? */
-            det = util::GR_zero() - per;
+            det = util::GR_zero<R>() - per;
         else
             det = per;
     }
@@ -104,42 +186,92 @@ GR_element EMatrix::per_m_det()
     return acc - det;
 }
 
-/* make all elements in row j even except for (i1,j)
- * return accumulator */
-GR_element EMatrix::row_op_per(const int i1, const int j)
+/* make all elements in column j even except for (i1,j). views of the
+ * projected matrices are appended to minors and the sum of the low sums
+ * of full vectors of them is returned, see per_similar. the rest are
+ * left in minors. P is the projection of this and is updated in place
+ * with the row operations */
+template <typename F>
+GF_element<F> EMatrix<F>::row_op_per(const int i1,
+                                     const int j,
+                                     const shared_ptr<FMatrix<F>> &P,
+                                     vector<Row_override<F>> &minors)
 {
-    GR_element acc = util::GR_zero();
-    const GR_element sigma = this->operator()(i1, j);
-    EMatrix mpp(this->get_n());
+    /* the inverse of sigma once for all of the rows */
+    typedef typename F::Ring R;
+    const GR_element<R> sigma_inv =
+        this->operator()(i1, j).project().inv().lift();
+    /* the odd rows and their multipliers */
+    vector<int> rows;
+    vector<GR_element<R>> t;
     for (int i2 = 0; i2 < this->get_n(); i2++)
     {
         if (i2 == i1)
             continue;
         if (!this->operator()(i2, j).is_even())
         {
-            const GR_element v = this->operator()(i2, j);
-            const GR_element t = util::tau(sigma, v);
+            rows.push_back(i2);
+            t.push_back(util::tau(sigma_inv, this->operator()(i2, j)));
+        }
+    }
 
-            /* M'' in the paper. Modify this as M' */
-            mpp.copy(*this);
+    /* M'' in the paper for rows[k] is M after the row operations on
+     * rows[0..k-1], with rows[k] replaced by t[k] times row i1. only its
+     * projection is needed and projecting commutes with the row
+     * operations, so each M'' is a view of the projection of M. row i1
+     * is not changed by the row operations */
+    vector<GF_element<F>> tp(this->get_n(), util::GF_zero<F>());
+    for (unsigned int k = 0; k < rows.size(); k++)
+    {
+        tp[rows[k]] = t[k].project();
+        minors.emplace_back(P, i1, rows[k], tp);
+    }
+    const GF_element<F> low = low_sum(minors, false);
 
-            this->row_op(i1, i2, t);
-            for (int col = 0; col < this->get_n(); col++)
-                mpp.set(i2, col, t * this->operator()(i1, col));
+    /* the row operations change different rows */
+    util::for_rows(0, rows.size(), [&](const int k)
+    {
+        this->row_op(i1, rows[k], t[k]);
+    });
+
+    if (rows.empty())
+        return low;
 
-            /* project creates new copy here */
-            acc += mpp.per_similar(i1, i2);
+    /* the views left for later keep the rows that change in P */
+    if (!minors.empty())
+    {
+        const int n = this->get_n();
+        shared_ptr<Saved_rows<F>> s = make_shared<Saved_rows<F>>();
+        s->index.assign(n, -1);
+        s->rows.reserve(rows.size() * n);
+        for (unsigned int k = 0; k < rows.size(); k++)
+        {
+            s->index[rows[k]] = k;
+            s->rows.insert(s->rows.end(), &(*P)(rows[k], 0),
+                           &(*P)(rows[k], 0) + n);
         }
+        for (Row_override<F> &view : minors)
+            view.save_rows(s);
     }
-    return acc;
+
+    /* only the rows of the row operations change in the projection */
+    for (unsigned int k = 0; k < rows.size(); k++)
+        for (int col = 0; col < this->get_n(); col++)
+            P->set(rows[k], col,
+                   this->operator()(rows[k], col).project());
+    return low;
 }
 
 /* permanent of a matrix where rows i1 and i2 are similar */
-GR_element EMatrix::per_similar(const int i1, const int i2) const
+template <typename F>
+GR_element<typename F::Ring> EMatrix<F>::per_similar(const int i1,
+                                                     const int i2) const
 {
-    Polynomial pdet = this->project_pdet(i1, i2);
-    GF_element sum = util::GF_zero();
-    for (int i = 0; i < this->get_n(); i++)
-        sum += pdet[i];
+    /* sum of the coefficients of pdet with degree < n */
+    const GF_element<F> sum = this->project().pdet_low_sum(i1, i2);
     return sum.lift() + sum.lift();
 }
+
+template class EMatrix<GF2_16>;
+template class EMatrix<GF2_32>;
+template class EMatrix<GF2_generic>;
@@ -4,6 +4,8 @@
 
 #include <iostream>
 #include <valarray>
+#include <vector>
+#include <memory>
 
 #include "extension.hh"
 #include "matrix.hh"
@@ -11,22 +13,29 @@
 #include "polynomial.hh"
 
 /* forward declare */
-class FMatrix;
+template <typename F> class FMatrix;
+template <typename F> class Row_override;
 
-class EMatrix : public Matrix<GR_element>
+/* matrix over the Galois ring of the field F, see GR_element */
+template <typename F>
+class EMatrix : public Matrix<GR_element<typename F::Ring>>
 {
 public:
-    using Matrix::Matrix;
+    using Matrix<GR_element<typename F::Ring>>::Matrix;
 
-    Polynomial project_pdet(const int i1, const int i2) const;
+    FMatrix<F> project() const;
 
     /* returns Per(this) - Det(this) as described in chapter 3
      * of the paper*/
-    GR_element per_m_det();
+    GR_element<typename F::Ring> per_m_det();
 
-    GR_element row_op_per(const int i1, const int j);
+    GF_element<F> row_op_per(const int i1,
+                             const int j,
+                             const std::shared_ptr<FMatrix<F>> &P,
+                             std::vector<Row_override<F>> &minors);
 
-    GR_element per_similar(const int i1, const int i2) const;
+    GR_element<typename F::Ring> per_similar(const int i1,
+                                             const int i2) const;
 };
 
 #endif
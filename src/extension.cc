@@ -11,6 +11,8 @@ GR4_n::GR4_n(const int e, const uint64_t g): n(e), mod(g)
 {
     this->mask = (1ll << this->n) - 1;
 
+    this->init_intel_rem();
+
     switch (n)
     {
     case 16:
@@ -40,11 +42,15 @@ GR4_n::GR4_n(const int e, const uint64_t g): n(e), mod(g)
     }
 }
 
-void GR4_n::init_varying_size()
+void GR4_n::init_intel_rem()
 {
-    /* "intel rem" distributive law optimization */
-    const GR_repr q_plus_repr =
-        this->quo({0, 1ull << (2*this->n)} , { 0, this->mod });
+    /* "intel rem" distributive law optimization. x^2n = x^n * mod -
+     * x^n * mod_ast, x^2n does not fit for n = 32 */
+    const GR_repr x_n_mod_ast = { 0, (this->mod & this->mask) << this->n };
+    const GR_repr q_plus_repr = this->add(
+        { 0, 1ull << this->n },
+        this->quo(this->negate(x_n_mod_ast), { 0, this->mod })
+    );
     for (int i = 0; i < this->n + 1; i++)
     {
         if (((this->mod >> i) & 1) && i < this->n)
@@ -63,7 +69,10 @@ void GR4_n::init_varying_size()
                                    : 0x0);
         }
     }
+}
 
+void GR4_n::init_varying_size()
+{
     /* montgomery multiplication */
     this->r_squared = {
         0,
@@ -174,148 +183,7 @@ GR_repr GR4_n::fast_mul(const GR_repr &a, const GR_repr &b) const
 
 GR_repr GR4_n::kronecker_mul(const GR_repr &a, const GR_repr &b) const
 {
-    /* we use different representation of polynomials than before here.
-     * each bit string can be split to sets of 2 bits where each set
-     * corresponds to a coefficient modulo 4. */
-    const kronecker_form aa = this->kronecker_substitution(a);
-    const kronecker_form bb = this->kronecker_substitution(b);
-
-    const uint512_t ahbh = bit::mul_256bit(aa.big, bb.big);
-    const uint512_t ahbl = bit::mul_256bit_64bit(aa.big, bb.small);
-    const uint512_t albh = bit::mul_256bit_64bit(bb.big, aa.small);
-    const uint64_t albl = aa.small * bb.small;
-
-    uint576_t prod = bit::add_576bit(
-        bit::widen_512bits(ahbh),
-        bit::pad_words(ahbl, 4)
-        );
-
-    prod = bit::add_576bit(
-        prod,
-        bit::pad_words(albh, 4)
-        );
-
-    /* can't overflow */
-    prod.words[8] += albl;
-
-    /* extract */
-
-    /* append zero bit to MSB of each word
-     * to make each word contain exactly 7 coefficients:
-     * 7*9 + 1 = 63 + 1 = 64 */
-
-    for (int i = 8; i > 0; i--)
-    {
-        prod.words[i] <<= i;
-        prod.words[i] |= prod.words[i-1] >> (64 - i);
-    }
-
-    uint64_t tmp[3];
-    tmp[0] = 0; tmp[1] = 0; tmp[2] = 0;
-
-    const uint64_t extmask = 0x00C06030180C0603ull;
-    for (int i = 0; i < 4; i++)
-        tmp[0] |= _pext_u64(prod.words[i], extmask) << (14*i);
-
-    for (int i = 4; i < 8; i++)
-        tmp[1] |= _pext_u64(prod.words[i], extmask) << (14*(i-4));
-
-    tmp[2] = _pext_u64(prod.words[8], extmask);
-
-    const uint64_t hiextmask = 0xAAAAAAAAAAAAAAAAull;
-    const uint64_t loextmask = 0x5555555555555555ull;
-    GR_repr ret = { 0, 0 };
-    for (int i = 0; i < 3; i++)
-    {
-        ret.hi |= _pext_u64(tmp[i], hiextmask) << (28*i);
-        ret.lo |= _pext_u64(tmp[i], loextmask) << (28*i);
-    }
-    return ret;
-}
-
-kronecker_form GR4_n::kronecker_substitution(const GR_repr &x) const
-{
-    /* combine lo and hi to single uint64_t
-     * where 2 bits represent single coefficient.
-     * the "more traditional" bit representation for polynomials */
-    const uint64_t comb_mask = 0x5555555555555555ull;
-    const uint64_t comb = _pdep_u64(x.lo, comb_mask)
-        | _pdep_u64(x.hi, comb_mask << 1);
-
-    /* contains the "polynomial" after kronecker substitution. */
-    kronecker_form kron;
-
-    /* each coefficients takes 9 bits.
-     * we have <= 32 coefficients. */
-
-    /* mask has 2x ones 7x zeros repeating */
-    const uint64_t extmask = 0x00C06030180C0603ull;
-    for (int i = 0; i < 4; i++)
-        kron.big.words[i] = _pdep_u64((comb >> (i*14)) & 0x3FFF, extmask);
-
-    /* remove the MSB zero from each word
-     * to make the bitstring continuous */
-    for (int i = 0; i < 3; i++)
-    {
-        kron.big.words[i] >>= i;
-        kron.big.words[i] |= kron.big.words[i+1] << (63 - i);
-    }
-    kron.small = _pdep_u64((comb >> 56) & 0xFF, extmask);
-    kron.big.words[3] >>= 3;
-    kron.big.words[3] |= kron.small << 60;
-    kron.small >>= 4;
-
-    return kron;
-}
-
-
-kronecker_form GR4_16::kronecker_substitution(const GR_repr &x) const
-{
-    /* combine lo and hi to single uint64_t
-     * where 2 bits represent single coefficient.
-     * the "more traditional" bit representation for polynomials */
-    const uint64_t comb_mask = 0x5555555555555555ull;
-    const uint64_t comb = _pdep_u64(x.lo, comb_mask)
-        | _pdep_u64(x.hi, comb_mask << 1);
-
-    /* contains the "polynomial" after kronecker substitution.
-     * for us it is sufficient that each coefficient has 8 bits,
-     * (see details in thesis) thus we need 16*8 = 128 bits
-     * for the polynomial after substitution. */
-    kronecker_form kron;
-    const uint64_t extmask = 0x0303030303030303ull;
-    kron.b16.words[0] = _pdep_u64(comb & 0xFFFF, extmask);
-    kron.b16.words[1] = _pdep_u64(comb >> 16, extmask);
-    return kron;
-}
-
-GR_repr GR4_16::kronecker_mul(const GR_repr &a, const GR_repr &b) const
-{
-
-    /* we use different representation of polynomials than before here.
-     * each bit string can be split to sets of 2 bits where each set
-     * corresponds to a coefficient modulo 4. */
-    const kronecker_form aa = this->kronecker_substitution(a);
-    const kronecker_form bb = this->kronecker_substitution(b);
-
-    const uint256_t prod = bit::mul_128bit(aa.b16, bb.b16);
-
-    /* first store the interesting bits to a uint64_t,
-     * that is the first two bits of each 8 bit limb.
-     * it fits, as we have deg <= 15+15 and each coefficient
-     * uses two bits. */
-    const uint64_t extmask = 0x0303030303030303ull;
-    uint64_t tmp = 0;
-    for (int i = 0; i < 4; i++)
-        tmp |= _pext_u64(prod.words[i], extmask) << (16*i);
-
-    /* extract the usual hi/lo representation */
-    const uint64_t hiextmask = 0xAAAAAAAAAAAAAAAAull;
-    const uint64_t loextmask = 0x5555555555555555ull;
-    GR_repr ret;
-    ret.lo = _pext_u64(tmp, loextmask);
-    ret.hi = _pext_u64(tmp, hiextmask);
-    return ret;
+    return kronecker::mul(a, b);
 }
 
 
@@ -360,42 +228,6 @@ GR_repr GR4_n::intel_rem(const GR_repr &a) const
     return this->subtract(lo, r);
 }
 
-GR_repr GR4_16::intel_rem(const GR_repr &a) const
-{
-    const GR_repr hi = a >> 16;
-    const GR_repr lo = a & 0xFFFF;
-
-    GR_repr tmp = hi >> 14;
-    tmp = this->add(tmp, hi >> 13);
-    tmp = this->add(tmp, hi >> 11);
-    tmp = this->subtract(hi, tmp);
-
-    GR_repr r = this->add(tmp, tmp << 2);
-    r = this->add(r, tmp << 3);
-    r = this->add(r, tmp << 5);
-
-    r &= 0xFFFF;
-    return this->subtract(lo, r);
-}
-
-GR_repr GR4_32::intel_rem(const GR_repr &a) const
-{
-    const GR_repr hi = a >> 32;
-    const GR_repr lo = a & 0xFFFFFFFF;
-
-    GR_repr tmp = hi >> 30;
-    tmp = this->add(tmp, hi >> 29);
-    tmp = this->add(tmp, hi >> 25);
-    tmp = this->subtract(hi, tmp);
-
-    GR_repr r = this->add(tmp, tmp << 2);
-    r = this->add(r, tmp << 3);
-    r = this->add(r, tmp << 7);
-
-    r &= 0xFFFFFFFF;
-    return this->subtract(lo, r);
-}
-
 GR_repr GR4_n::mont_rem(const GR_repr &a) const
 {
     /* n-1 deg + n-1 deg */
@@ -406,8 +238,3 @@ GR_repr GR4_n::mont_rem(const GR_repr &a) const
 
     return c;
 }
-
-GF_element GR_element::project() const
-{
-    return GF_element(this->repr.lo);
-}
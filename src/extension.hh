@@ -5,16 +5,13 @@
 #include <iostream>
 #include <stdint.h>
 #include <immintrin.h>
+#include <utility>
 
 #include "gf.hh"
 #include "util.hh"
 #include "global.hh"
 #include "bitvectors.hh"
 
-/* forward declare */
-class GF_element;
-class GR_element;
-
 /* representation for elements of E(4^n)
  * each bit in lo is the low bit of the mod 4 coefficient.
  * similarly for hi
@@ -84,6 +81,160 @@ struct kronecker_form
     uint128_t b16;
 };
 
+/* multiplication of polynomials over Z4 by kronecker substitution.
+ * inline so that the rings of GR4<N, MOD> can inline them */
+namespace kronecker
+{
+    /* the kronecker substitution for at most 32 coefficients */
+    inline kronecker_form substitution(const GR_repr &x)
+    {
+        /* combine lo and hi to single uint64_t
+         * where 2 bits represent single coefficient.
+         * the "more traditional" bit representation for polynomials */
+        const uint64_t comb_mask = 0x5555555555555555ull;
+        const uint64_t comb = _pdep_u64(x.lo, comb_mask)
+            | _pdep_u64(x.hi, comb_mask << 1);
+
+        /* contains the "polynomial" after kronecker substitution. */
+        kronecker_form kron;
+
+        /* each coefficients takes 9 bits.
+         * we have <= 32 coefficients. */
+
+        /* mask has 2x ones 7x zeros repeating */
+        const uint64_t extmask = 0x00C06030180C0603ull;
+        for (int i = 0; i < 4; i++)
+            kron.big.words[i] = _pdep_u64((comb >> (i*14)) & 0x3FFF, extmask);
+
+        /* remove the MSB zero from each word
+         * to make the bitstring continuous */
+        for (int i = 0; i < 3; i++)
+        {
+            kron.big.words[i] >>= i;
+            kron.big.words[i] |= kron.big.words[i+1] << (63 - i);
+        }
+        kron.small = _pdep_u64((comb >> 56) & 0xFF, extmask);
+        kron.big.words[3] >>= 3;
+        kron.big.words[3] |= kron.small << 60;
+        kron.small >>= 4;
+
+        return kron;
+    }
+
+    /* product of polynomials of degree < 32 */
+    inline GR_repr mul(const GR_repr &a, const GR_repr &b)
+    {
+        /* we use different representation of polynomials than before here.
+         * each bit string can be split to sets of 2 bits where each set
+         * corresponds to a coefficient modulo 4. */
+        const kronecker_form aa = substitution(a);
+        const kronecker_form bb = substitution(b);
+
+        const uint512_t ahbh = bit::mul_256bit(aa.big, bb.big);
+        const uint512_t ahbl = bit::mul_256bit_64bit(aa.big, bb.small);
+        const uint512_t albh = bit::mul_256bit_64bit(bb.big, aa.small);
+        const uint64_t albl = aa.small * bb.small;
+
+        uint576_t prod = bit::add_576bit(
+            bit::widen_512bits(ahbh),
+            bit::pad_words(ahbl, 4)
+            );
+
+        prod = bit::add_576bit(
+            prod,
+            bit::pad_words(albh, 4)
+            );
+
+        /* can't overflow */
+        prod.words[8] += albl;
+
+        /* extract */
+
+        /* append zero bit to MSB of each word
+         * to make each word contain exactly 7 coefficients:
+         * 7*9 + 1 = 63 + 1 = 64 */
+
+        for (int i = 8; i > 0; i--)
+        {
+            prod.words[i] <<= i;
+            prod.words[i] |= prod.words[i-1] >> (64 - i);
+        }
+
+        uint64_t tmp[3];
+        tmp[0] = 0; tmp[1] = 0; tmp[2] = 0;
+
+        const uint64_t extmask = 0x00C06030180C0603ull;
+        for (int i = 0; i < 4; i++)
+            tmp[0] |= _pext_u64(prod.words[i], extmask) << (14*i);
+
+        for (int i = 4; i < 8; i++)
+            tmp[1] |= _pext_u64(prod.words[i], extmask) << (14*(i-4));
+
+        tmp[2] = _pext_u64(prod.words[8], extmask);
+
+        const uint64_t hiextmask = 0xAAAAAAAAAAAAAAAAull;
+        const uint64_t loextmask = 0x5555555555555555ull;
+        GR_repr ret = { 0, 0 };
+        for (int i = 0; i < 3; i++)
+        {
+            ret.hi |= _pext_u64(tmp[i], hiextmask) << (28*i);
+            ret.lo |= _pext_u64(tmp[i], loextmask) << (28*i);
+        }
+        return ret;
+    }
+
+    /* substitution for at most 16 coefficients */
+    inline kronecker_form substitution_16(const GR_repr &x)
+    {
+        /* combine lo and hi to single uint64_t
+         * where 2 bits represent single coefficient.
+         * the "more traditional" bit representation for polynomials */
+        const uint64_t comb_mask = 0x5555555555555555ull;
+        const uint64_t comb = _pdep_u64(x.lo, comb_mask)
+            | _pdep_u64(x.hi, comb_mask << 1);
+
+        /* contains the "polynomial" after kronecker substitution.
+         * for us it is sufficient that each coefficient has 8 bits,
+         * (see details in thesis) thus we need 16*8 = 128 bits
+         * for the polynomial after substitution. */
+        kronecker_form kron;
+        const uint64_t extmask = 0x0303030303030303ull;
+        kron.b16.words[0] = _pdep_u64(comb & 0xFFFF, extmask);
+        kron.b16.words[1] = _pdep_u64(comb >> 16, extmask);
+        return kron;
+    }
+
+    /* product of polynomials of degree < 16 */
+    inline GR_repr mul_16(const GR_repr &a, const GR_repr &b)
+    {
+
+        /* we use different representation of polynomials than before here.
+         * each bit string can be split to sets of 2 bits where each set
+         * corresponds to a coefficient modulo 4. */
+        const kronecker_form aa = substitution_16(a);
+        const kronecker_form bb = substitution_16(b);
+
+        const uint256_t prod = bit::mul_128bit(aa.b16, bb.b16);
+
+        /* first store the interesting bits to a uint64_t,
+         * that is the first two bits of each 8 bit limb.
+         * it fits, as we have deg <= 15+15 and each coefficient
+         * uses two bits. */
+        const uint64_t extmask = 0x0303030303030303ull;
+        uint64_t tmp = 0;
+        for (int i = 0; i < 4; i++)
+            tmp |= _pext_u64(prod.words[i], extmask) << (16*i);
+
+        /* extract the usual hi/lo representation */
+        const uint64_t hiextmask = 0xAAAAAAAAAAAAAAAAull;
+        const uint64_t loextmask = 0x5555555555555555ull;
+        GR_repr ret;
+        ret.lo = _pext_u64(tmp, loextmask);
+        ret.hi = _pext_u64(tmp, hiextmask);
+        return ret;
+    }
+}
+
 /* Extension of GF(2^n) to the ring E(4^n).
  * If GF(2^n) = Z2 / <g_2> for irreducible polynomial
  * g_2 of degree n, then if g_4 is g_2 but coefficients
@@ -105,18 +256,20 @@ private:
      * b has to be monic for this to work */
     GR_repr quo(GR_repr a, GR_repr b) const;
 
+    void init_intel_rem();
     void init_varying_size();
 
 public:
     GR4_n(const int e, const uint64_t g);
 
-    inline GR_repr add(const GR_repr &a, const GR_repr &b) const
+    /* the coefficient-wise operations don't depend on the modulus */
+    static constexpr inline GR_repr add(const GR_repr &a, const GR_repr &b)
     {
         const uint64_t carry = a.lo & b.lo;
         return { carry ^ a.hi ^ b.hi, a.lo ^ b.lo };
     }
 
-    inline GR_repr negate(const GR_repr &a) const
+    static constexpr inline GR_repr negate(const GR_repr &a)
     {
         return {
             a.lo ^ a.hi,
@@ -124,12 +277,12 @@ public:
         };
     }
 
-    inline GR_repr subtract(const GR_repr &a, const GR_repr &b) const
+    static constexpr inline GR_repr subtract(const GR_repr &a, const GR_repr &b)
     {
-        return this->add(a, this->negate(b));
+        return add(a, negate(b));
     }
 
-    inline GR_repr mul_const(const GR_repr &a, const GR_repr &c) const
+    static constexpr inline GR_repr mul_const(const GR_repr &a, const GR_repr &c)
     {
         return {
             (a.hi & c.lo) ^ (a.lo & c.hi),
@@ -137,26 +290,27 @@ public:
         };
     }
 
+    /* kronecker_mul and intel_rem for any modulus. GR4<N, MOD> below
+     * compiles them for a fixed one */
     inline GR_repr mul(const GR_repr &a, const GR_repr &b) const
     {
-        return kronecker_mul(a, b);
+        return kronecker::mul(a, b);
     }
 
     GR_repr ref_mul(const GR_repr &a, const GR_repr &b) const;
 
     GR_repr fast_mul(const GR_repr &a, const GR_repr &b) const;
 
-    virtual GR_repr kronecker_mul(const GR_repr &a, const GR_repr &b) const;
-    virtual kronecker_form kronecker_substitution(const GR_repr &x) const;
+    GR_repr kronecker_mul(const GR_repr &a, const GR_repr &b) const;
 
     inline GR_repr rem(const GR_repr &a) const
     {
-        return intel_rem(a);
+        return this->intel_rem(a);
     }
 
     GR_repr euclid_rem(const GR_repr &a) const;
 
-    virtual GR_repr intel_rem(const GR_repr &a) const;
+    GR_repr intel_rem(const GR_repr &a) const;
 
     GR_repr mont_rem(const GR_repr &a) const;
     inline GR_repr mont_form(const GR_repr &a) const
@@ -173,25 +327,151 @@ public:
     inline uint64_t get_mask() const { return this->mask; }
 };
 
-class GR4_16 : public GR4_n
+/* E(4^N) with the modulus fixed at compile time. like GF2<N, MOD>,
+ * the shifts and Z4 coefficients of the "intel rem" are generated from
+ * MOD, so mul and rem inline into the callers. GR_element takes the
+ * ring as a type with these static functions, see GR4_generic for
+ * the other rings */
+template <int N, uint64_t MOD>
+struct GR4
 {
-public:
-    using GR4_n::GR4_n;
+    /* the field of the projections */
+    typedef GF2<N, MOD> Field;
+
+    static constexpr uint64_t MASK = (1ull << N) - 1;
+    static constexpr uint64_t MOD_AST = MOD & MASK;
+
+    /* quotient of x^2N by MOD */
+    static constexpr GR_repr q_plus()
+    {
+        /* x^2N = x^N * MOD - x^N * MOD_AST */
+        GR_repr a = GR4_n::negate({ 0, MOD_AST << N });
+        GR_repr q = { 0, 0 };
+        while ((a.hi | a.lo) >> N)
+        {
+            int deg = 63;
+            while (!(((a.hi | a.lo) >> deg) & 1))
+                deg--;
+            const GR_repr c = {
+                ((a.hi >> deg) & 1) ? ~0ull : 0ull,
+                ((a.lo >> deg) & 1) ? ~0ull : 0ull
+            };
+            const GR_repr s = GR4_n::mul_const({ 0, 1ull << (deg - N) }, c);
+            const GR_repr sb = GR4_n::mul_const({ 0, MOD << (deg - N) }, c);
+            q = GR4_n::add(q, s);
+            a = GR4_n::subtract(a, sb);
+        }
+        return GR4_n::add(q, { 0, 1ull << N });
+    }
+
+    static constexpr GR_repr Q_PLUS = q_plus();
+
+    /* hi has degree <= N - 2, so coefficients below 2 vanish */
+    static constexpr int Q_COUNT =
+        __builtin_popcountll((Q_PLUS.hi | Q_PLUS.lo) >> 2);
+    static constexpr int MOD_COUNT = __builtin_popcountll(MOD_AST);
+
+    struct Shifts
+    {
+        int q[Q_COUNT > 0 ? Q_COUNT : 1];
+        /* coefficient of the shift as masks */
+        GR_repr qc[Q_COUNT > 0 ? Q_COUNT : 1];
+        int mod[MOD_COUNT > 0 ? MOD_COUNT : 1];
+    };
+
+    static constexpr Shifts shifts()
+    {
+        Shifts s = { };
+        int k = 0;
+        for (int i = N; i >= 2; i--)
+        {
+            if (((Q_PLUS.hi | Q_PLUS.lo) >> i) & 1)
+            {
+                s.q[k] = N - i;
+                s.qc[k] = {
+                    ((Q_PLUS.hi >> i) & 1) ? ~0ull : 0ull,
+                    ((Q_PLUS.lo >> i) & 1) ? ~0ull : 0ull
+                };
+                k++;
+            }
+        }
+        k = 0;
+        for (int i = 0; i < N; i++)
+            if ((MOD_AST >> i) & 1)
+                s.mod[k++] = i;
+        return s;
+    }
+
+    static constexpr Shifts SHIFTS = shifts();
+
+    template <std::size_t... I>
+    static inline GR_repr quo_hi(const GR_repr &hi, std::index_sequence<I...>)
+    {
+        GR_repr q = { 0, 0 };
+        ((q = GR4_n::add(q, GR4_n::mul_const(hi >> SHIFTS.q[I], SHIFTS.qc[I]))), ...);
+        return q;
+    }
 
-    kronecker_form kronecker_substitution(const GR_repr &x) const override;
-    GR_repr kronecker_mul(const GR_repr &a, const GR_repr &b) const override;
+    template <std::size_t... I>
+    static inline GR_repr mul_ast(const GR_repr &q, std::index_sequence<I...>)
+    {
+        GR_repr r = { 0, 0 };
+        ((r = GR4_n::add(r, q << SHIFTS.mod[I])), ...);
+        return r;
+    }
 
-    GR_repr intel_rem(const GR_repr &a) const override;
+    static inline GR_repr mul(const GR_repr &a, const GR_repr &b)
+    {
+        if constexpr (N <= 16)
+            return kronecker::mul_16(a, b);
+        else
+            return kronecker::mul(a, b);
+    }
+
+    static inline GR_repr rem(const GR_repr &a)
+    {
+        const GR_repr hi = a >> N;
+        const GR_repr lo = a & MASK;
+
+        const GR_repr q = quo_hi(hi, std::make_index_sequence<Q_COUNT>());
+        const GR_repr r = mul_ast(q, std::make_index_sequence<MOD_COUNT>());
+        return GR4_n::subtract(lo, r & MASK);
+    }
+
+    static constexpr int get_n() { return N; }
+    static constexpr uint64_t get_mod() { return MOD; }
+    static constexpr uint64_t get_mask() { return MASK; }
 };
 
-class GR4_32 : public GR4_n
+/* the rings of GF2_16 and GF2_32 */
+/* x^16 + x^5 + x^3 + x^2 +  1 */
+typedef GR4<16, 0x1002D> GR4_16;
+/* x^32 + x^7 + x^3 + x^2 + 1 */
+typedef GR4<32, 0x10000008D> GR4_32;
+
+/* the ring of GF2_generic, the same functions as GR4<N, MOD> with
+ * the modulus and the constants of global::E */
+struct GR4_generic
 {
-public:
-    using GR4_n::GR4_n;
+    typedef GF2_generic Field;
+
+    static inline GR_repr mul(const GR_repr &a, const GR_repr &b)
+    {
+        return global::E->mul(a, b);
+    }
 
-    GR_repr intel_rem(const GR_repr &a) const override;
+    static inline GR_repr rem(const GR_repr &a)
+    {
+        return global::E->rem(a);
+    }
+
+    static inline int get_n() { return global::E->get_n(); }
+    static inline uint64_t get_mod() { return global::E->get_mod(); }
+    static inline uint64_t get_mask() { return global::E->get_mask(); }
 };
 
+/* element of the ring R, one of the ring types above */
+template <typename R>
 class GR_element
 {
 private:
@@ -209,39 +489,39 @@ public:
     inline GR_element operator+(const GR_element &other) const
     {
         return GR_element(
-            global::E->add(this->repr, other.get_repr())
+            GR4_n::add(this->repr, other.get_repr())
         );
     }
 
     inline GR_element &operator+=(const GR_element &other)
     {
-        this->repr = global::E->add(this->repr, other.get_repr());
+        this->repr = GR4_n::add(this->repr, other.get_repr());
         return *this;
     }
 
     inline GR_element operator-(const GR_element &other) const
     {
         return GR_element(
-            global::E->subtract(this->repr, other.get_repr())
+            GR4_n::subtract(this->repr, other.get_repr())
         );
     }
 
     inline GR_element &operator-=(const GR_element &other)
     {
-        this->repr = global::E->subtract(this->repr, other.get_repr());
+        this->repr = GR4_n::subtract(this->repr, other.get_repr());
         return *this;
     }
 
     inline GR_element operator*(const GR_element &other) const
     {
-        GR_repr prod = global::E->mul(this->repr, other.get_repr());
-        return GR_element(global::E->rem(prod));
+        GR_repr prod = R::mul(this->repr, other.get_repr());
+        return GR_element(R::rem(prod));
     }
 
     inline GR_element &operator*=(const GR_element &other)
     {
-        GR_repr prod = global::E->mul(this->repr, other.get_repr());
-        this->repr = global::E->rem(prod);
+        GR_repr prod = R::mul(this->repr, other.get_repr());
+        this->repr = R::rem(prod);
         return *this;
     }
 
@@ -270,7 +550,10 @@ public:
     inline uint64_t get_hi() const { return this->repr.hi; }
     inline GR_repr get_repr() const { return this->repr; }
 
-    GF_element project() const;
+    inline GF_element<typename R::Field> project() const
+    {
+        return GF_element<typename R::Field>(this->repr.lo);
+    }
 
     inline GR_element &operator=(const GR_element &other)
     {
@@ -297,28 +580,42 @@ public:
     }
 };
 
+template <typename F>
+inline GR_element<typename F::Ring> GF_element<F>::lift() const
+{
+    return GR_element<typename F::Ring>(0x0, this->repr);
+}
+
 namespace util
 {
-    inline GR_element tau(const GR_element &sigma, const GR_element &v)
+    /* multiplier that makes v - sigma * tau even for odd sigma. takes
+     * the lifted inverse of the projection of sigma so that a column
+     * inverts sigma once */
+    template <typename R>
+    inline GR_element<R> tau(const GR_element<R> &sigma_inv,
+                             const GR_element<R> &v)
     {
-        return sigma.project().inv().lift() * v;
+        return sigma_inv * v;
     }
 
-    inline GR_element GR_zero()
+    template <typename R>
+    inline GR_element<R> GR_zero()
     {
-        return GR_element(0b0, 0b0);
+        return GR_element<R>(0b0, 0b0);
     }
 
-    inline GR_element GR_one()
+    template <typename R>
+    inline GR_element<R> GR_one()
     {
-        return GR_element(0b0, 0b1);
+        return GR_element<R>(0b0, 0b1);
     }
 
-    inline GR_element GR_random()
+    template <typename R>
+    inline GR_element<R> GR_random()
     {
-        return GR_element(
-            global::randgen() & global::E->get_mask(),
-            global::randgen() & global::E->get_mask()
+        return GR_element<R>(
+            global::randgen() & R::get_mask(),
+            global::randgen() & R::get_mask()
         );
     }
 }
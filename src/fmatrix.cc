@@ -1,19 +1,23 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <valarray>
 #include <vector>
+#include <type_traits>
 
 #include "global.hh"
 #include "fmatrix.hh"
 #include "ematrix.hh"
 #include "extension.hh"
 #include "packed_fmatrix.hh"
+#include "batched_fmatrix.hh"
+#include "small_det.hh"
 
 using namespace std;
 
 /* multiply diagonal by e and lift the resulting matrix */
-EMatrix FMatrix::mul_diag_lift(const GF_element &e) const
+template <typename F>
+EMatrix<F> FMatrix<F>::mul_diag_lift(const GF_element<F> &e) const
 {
-    EMatrix m(this->get_n());
+    EMatrix<F> m(this->get_n());
 
     for (int row = 0; row < this->get_n(); row++)
     {
@@ -29,9 +33,12 @@ EMatrix FMatrix::mul_diag_lift(const GF_element &e) const
     return m;
 }
 
-void FMatrix::mul_gamma(const int r1, const int r2, const GF_element &gamma)
+template <typename F>
+void FMatrix<F>::mul_gamma(const int r1,
+                           const int r2,
+                           const GF_element<F> &gamma)
 {
-    GF_element prod = gamma;
+    GF_element<F> prod = gamma;
     for (int col = 1; col < this->get_n(); col++)
     {
         this->mul(r1, col, prod);
@@ -41,29 +48,50 @@ void FMatrix::mul_gamma(const int r1, const int r2, const GF_element &gamma)
 }
 
 /* swap rows r1 and r2 starting from column idx */
-void FMatrix::swap_rows(const int r1, const int r2, const int idx)
+template <typename F>
+void FMatrix<F>::swap_rows(const int r1, const int r2, const int idx)
 {
     for (int col = idx; col < this->get_n(); col++)
     {
-        const GF_element tmp = this->operator()(r1, col);
+        const GF_element<F> tmp = this->operator()(r1, col);
         this->set(r1, col, this->operator()(r2,col));
         this->set(r2, col, tmp);
     }
 }
 
+template <typename F>
+GF_element<F> FMatrix<F>::det()
+{
+    const int d = this->get_n();
+    if (d < 2 || d > SMALL_DET_MAX)
+        return this->det_elimination();
+
+    /* the generic packed multiplications lose to the scalar
+     * elimination, only the expansions pay off with them */
+    if constexpr (is_same_v<F, GF2_16>)
+        return dispatch_small_det<F, Wide_16>(*this);
+    else if constexpr (is_same_v<F, GF2_32>)
+        return dispatch_small_det<F, Wide_32>(*this);
+    else if (d <= SMALL_DET_EXPANSION)
+        return dispatch_small_det_expansion<F>(*this);
+    else
+        return this->det_elimination();
+}
+
 /* simple gaussian elimination with pivoting.
  * we are in characteristic two so pivoting does
  * not affect the determinant. */
-GF_element FMatrix::det()
+template <typename F>
+GF_element<F> FMatrix<F>::det_elimination()
 {
-    GF_element det = util::GF_one();
+    GF_element<F> det = util::GF_one<F>();
     for (int col = 0; col < this->get_n(); col++)
     {
         /* pivot */
         int pivot_idx = -1;
         for (int row = col; row < this->get_n(); row++)
         {
-            if (this->operator()(row,col) != util::GF_zero())
+            if (this->operator()(row,col) != util::GF_zero<F>())
             {
                 pivot_idx = row;
                 break;
@@ -71,61 +99,312 @@ GF_element FMatrix::det()
         }
 
         if (pivot_idx == -1)
-            return util::GF_zero();
+            return util::GF_zero<F>();
 
         if (pivot_idx != col)
             this->swap_rows(pivot_idx, col, col);
 
-        GF_element pivot = this->operator()(col, col);
+        GF_element<F> pivot = this->operator()(col, col);
         det *= pivot;
         pivot.inv_in_place();
         this->mul_row(col, pivot, col);
 
-        for (int row = col+1; row < this->get_n(); row++)
-            /* create new element or do row,col last? */
-            this->row_op(col, row, GF_element(this->operator()(row,col)), col);
+        util::for_rows(col + 1, this->get_n(), [&](const int row)
+        {
+            this->row_op(col, row, GF_element<F>(this->operator()(row, col)),
+                         col);
+        });
     }
     return det;
 }
 
-/* uses random sampling and la grange interpolation
- * to get the polynomial determinant. rows r1 and r2 are similar. */
-Polynomial FMatrix::pdet(const int r1, const int r2) const
+/* reduces the rows other than r1 and r2 to row echelon form. if they
+ * are linearly independent, there are exactly two columns c1 and c2
+ * without a pivot. if u and v are reduced with the rows to u' and v',
+ * then u' and v' are zero outside of c1 and c2 and
+ * det = lambda * (u'_c1 v'_c2 + u'_c2 v'_c1), where lambda is the product
+ * of the pivots. u'_c1 = <u,w1> and so on, where w1 is obtained from the
+ * reduced row echelon form by back substitution. */
+template <typename F>
+bool FMatrix<F>::cofactors(const int r1,
+                           const int r2,
+                           GF_element<F> &lambda,
+                           vector<GF_element<F>> &w1,
+                           vector<GF_element<F>> &w2) const
 {
-    /* determinant has deg <= 2*n - 2 */
-    const vector<GF_element> gamma = util::distinct_elements(2*this->get_n() - 1);
-    vector<GF_element> delta(2*this->get_n() - 1);
+    const int n = this->get_n();
+    FMatrix<F> B(n);
+    B.copy(*this);
+
+    vector<int> rows;
+    for (int row = 0; row < n; row++)
+        if (row != r1 && row != r2)
+            rows.push_back(row);
 
-    if (global::F->get_n() != 16)
+    /* pivot column of rows[i] */
+    vector<int> pivots;
+    vector<int> free;
+
+    lambda = util::GF_one<F>();
+    for (int col = 0; col < n; col++)
     {
-        FMatrix A(this->get_n());
+        const int next = pivots.size();
+        int piv_idx = -1;
+        for (int i = next; i < (int) rows.size(); i++)
+        {
+            if (B(rows[i], col) != util::GF_zero<F>())
+            {
+                piv_idx = i;
+                break;
+            }
+        }
 
-        for (int i = 0; i < 2*this->get_n() - 1; i++)
+        if (piv_idx == -1)
         {
-            A.copy(*this);
-            A.mul_gamma(r1, r2, gamma[i]);
-            delta[i] = A.det();
+            free.push_back(col);
+            /* rows are linearly dependent */
+            if (free.size() > 2)
+                return false;
+            continue;
+        }
+
+        /* swapping indices is enough, order does not matter */
+        swap(rows[piv_idx], rows[next]);
+        const int row = rows[next];
+
+        GF_element<F> pivot = B(row, col);
+        lambda *= pivot;
+        pivot.inv_in_place();
+
+        /* free columns before col are not zero in the rows */
+        const int idx = (free.empty()) ? col : free[0];
+        B.mul_row(row, pivot, idx);
+        util::for_rows(next + 1, rows.size(), [&](const int i)
+        {
+            B.row_op(row, rows[i], GF_element<F>(B(rows[i], col)), idx);
+        });
+
+        pivots.push_back(col);
+    }
+
+    const int c1 = free[0];
+    const int c2 = free[1];
+
+    w1.assign(n, util::GF_zero<F>());
+    w2.assign(n, util::GF_zero<F>());
+    w1[c1] = util::GF_one<F>();
+    w2[c2] = util::GF_one<F>();
+
+    /* back substitution, only for the columns c1 and c2.
+     * we are in characteristic two, so w[pivot] is directly the element
+     * at the free column of the reduced row echelon form. */
+    for (int i = pivots.size() - 1; i >= 0; i--)
+    {
+        const int row = rows[i];
+        GF_element<F> x1 = B(row, c1);
+        GF_element<F> x2 = B(row, c2);
+        for (int j = i + 1; j < (int) pivots.size(); j++)
+        {
+            const GF_element<F> e = B(row, pivots[j]);
+            x1 += e * w1[pivots[j]];
+            x2 += e * w2[pivots[j]];
         }
+        w1[pivots[i]] = x1;
+        w2[pivots[i]] = x2;
     }
-    else
+
+    return true;
+}
+
+/* the determinant is bilinear in rows r1 and r2, so the polynomial is
+ * lambda * (P1*Q2 + P2*Q1), where P1, P2 and Q1, Q2 are given by
+ * the monomials and the functionals w1 and w2. */
+template <typename F>
+Polynomial<F> FMatrix<F>::pdet(const int r1, const int r2) const
+{
+    const int n = this->get_n();
+    Polynomial<F> pdet(2*n - 2);
+
+    GF_element<F> lambda;
+    vector<GF_element<F>> w1;
+    vector<GF_element<F>> w2;
+    if (!this->cofactors(r1, r2, lambda, w1, w2))
+        return pdet;
+
+    vector<GF_element<F>> P1(n);
+    vector<GF_element<F>> P2(n);
+    vector<GF_element<F>> Q1(n);
+    vector<GF_element<F>> Q2(n);
+    for (int i = 0; i < n; i++)
     {
-        Packed_FMatrix PA(this->get_n(), *this);
+        const GF_element<F> u = lambda * this->operator()(r1, i);
+        P1[i] = u * w1[i];
+        P2[i] = u * w2[i];
+        Q1[n - 1 - i] = this->operator()(r2, i) * w1[i];
+        Q2[n - 1 - i] = this->operator()(r2, i) * w2[i];
+    }
+
+    pdet = Polynomial<F>(P1) * Polynomial<F>(Q2);
+    pdet += Polynomial<F>(P2) * Polynomial<F>(Q1);
+
+    return pdet;
+}
+
+/* only the sum of the coefficients is needed, so
+ * its enough to compute prefix sums of Q1 and Q2. */
+template <typename F>
+GF_element<F> FMatrix<F>::pdet_low_sum(const int r1, const int r2) const
+{
+    const int n = this->get_n();
+
+    GF_element<F> lambda;
+    vector<GF_element<F>> w1;
+    vector<GF_element<F>> w2;
+    if (!this->cofactors(r1, r2, lambda, w1, w2))
+        return util::GF_zero<F>();
+
+    /* prefix sums, S1[j] = sum_{i <= j} Q1[i] */
+    vector<GF_element<F>> S1(n);
+    vector<GF_element<F>> S2(n);
+    GF_element<F> s1 = util::GF_zero<F>();
+    GF_element<F> s2 = util::GF_zero<F>();
+    for (int j = 0; j < n; j++)
+    {
+        s1 += this->operator()(r2, n - 1 - j) * w1[n - 1 - j];
+        s2 += this->operator()(r2, n - 1 - j) * w2[n - 1 - j];
+        S1[j] = s1;
+        S2[j] = s2;
+    }
+
+    GF_element<F> sum = util::GF_zero<F>();
+    for (int i = 0; i < n; i++)
+    {
+        const GF_element<F> u = this->operator()(r1, i);
+        sum += u * (w1[i] * S2[n - 1 - i] + w2[i] * S1[n - 1 - i]);
+    }
+
+    return lambda * sum;
+}
+
+/* determinants of the gamma multiplied matrices on the packed matrix */
+template <typename F, typename W>
+static void packed_dets(const FMatrix<F> &m,
+                        const int r1,
+                        const int r2,
+                        const vector<GF_element<F>> &gamma,
+                        vector<GF_element<F>> &delta
+)
+{
+    /* each gamma is a task with its own copy of the matrix */
+    #pragma omp taskloop grainsize(1) shared(m, gamma, delta)
+    for (unsigned int i = 0; i < gamma.size(); i++)
+    {
+        Packed_FMatrix<F, W> PA(m.get_n(), m);
+        PA.init();
+        PA.mul_gamma(r1, r2, gamma[i]);
+        delta[i] = (m.get_n() <= W::FRACTION_FREE_MAX)
+            ? PA.det_fraction_free() : PA.det();
+    }
+}
+
+/* same with a gamma in each lane */
+template <typename F, typename W>
+static void batched_dets(const FMatrix<F> &m,
+                         const int r1,
+                         const int r2,
+                         const vector<GF_element<F>> &gamma,
+                         vector<GF_element<F>> &delta
+)
+{
+    constexpr int LANES = Batched_FMatrix<F, W>::lanes();
+
+    /* a task for each batch */
+    #pragma omp taskloop grainsize(1) shared(m, gamma, delta)
+    for (unsigned int i = 0; i < gamma.size(); i += LANES)
+    {
+        Batched_FMatrix<F, W> BA(m, r1, r2);
+        /* the last batch is padded by repeating the last gamma */
+        GF_element<F> g[LANES];
+        GF_element<F> d[LANES];
+        for (int j = 0; j < LANES; j++)
+            g[j] = gamma[min(i + j, (unsigned int) gamma.size() - 1)];
 
+        BA.init(g);
+        BA.det(d);
+        for (int j = 0; j < LANES && i + j < gamma.size(); j++)
+            delta[i + j] = d[j];
+    }
+}
+
+template <typename F>
+Polynomial<F> FMatrix<F>::pdet_interpolation(const int r1,
+                                             const int r2,
+                                             const Det_engine engine,
+                                             const Interpolation_mode mode
+) const
+{
+    /* determinant has deg <= 2*n - 2 */
+    const Interpolation_plan<F> plan(2*this->get_n() - 1, mode);
+    return this->pdet_interpolation(r1, r2, plan, engine);
+}
+
+/* evaluates the determinant at the points of the plan and
+ * interpolates. rows r1 and r2 are similar. */
+template <typename F>
+Polynomial<F> FMatrix<F>::pdet_interpolation(const int r1,
+                                             const int r2,
+                                             const Interpolation_plan<F> &plan,
+                                             const Det_engine engine
+) const
+{
+    const vector<GF_element<F>> &gamma = plan.get_points();
+    vector<GF_element<F>> delta(2*this->get_n() - 1);
+
+    switch (engine)
+    {
+    case SCALAR_DET:
+        #pragma omp taskloop grainsize(1) shared(gamma, delta)
         for (int i = 0; i < 2*this->get_n() - 1; i++)
         {
-            PA.init();
-            PA.mul_gamma(r1, r2, gamma[i]);
-            delta[i] = PA.det();
+            FMatrix<F> A(this->get_n());
+            A.copy(*this);
+            A.mul_gamma(r1, r2, gamma[i]);
+            delta[i] = A.det();
         }
+        break;
+    case PACKED_DET:
+        if constexpr (is_same_v<F, GF2_16>)
+            packed_dets<F, Wide_16>(*this, r1, r2, gamma, delta);
+        else if constexpr (is_same_v<F, GF2_32>)
+            packed_dets<F, Wide_32>(*this, r1, r2, gamma, delta);
+        else if (F::get_n() < 16)
+            packed_dets<F, Wide_n>(*this, r1, r2, gamma, delta);
+        else
+            packed_dets<F, Wide_n_64>(*this, r1, r2, gamma, delta);
+        break;
+    case BATCHED_DET:
+        if constexpr (is_same_v<F, GF2_16>)
+            batched_dets<F, Wide_16>(*this, r1, r2, gamma, delta);
+        else if constexpr (is_same_v<F, GF2_32>)
+            batched_dets<F, Wide_32>(*this, r1, r2, gamma, delta);
+        else if (F::get_n() < 16)
+            batched_dets<F, Wide_n>(*this, r1, r2, gamma, delta);
+        else
+            batched_dets<F, Wide_n_64>(*this, r1, r2, gamma, delta);
+        break;
     }
 
-    /* la grange */
-    return util::poly_interpolation(gamma, delta);
+    return plan.interpolate(delta);
 }
 
-GF_element FMatrix::pcc(const GF_element &e) const
+template <typename F>
+GF_element<F> FMatrix<F>::pcc(const GF_element<F> &e) const
 {
-    EMatrix E = this->mul_diag_lift(e);
-    const GR_element elem = E.per_m_det();
+    EMatrix<F> E = this->mul_diag_lift(e);
+    const GR_element<typename F::Ring> elem = E.per_m_det();
     return elem.div2().project();
 }
+
+template class FMatrix<GF2_16>;
+template class FMatrix<GF2_32>;
+template class FMatrix<GF2_generic>;
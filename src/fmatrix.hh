@@ -12,35 +12,74 @@
 #include "polynomial.hh"
 
 /* forward declare */
+template <typename F>
 class EMatrix;
 
-class FMatrix : public Matrix<GF_element>
+/* how pdet_interpolation computes the determinants. packed vectorizes
+ * over the columns of one matrix, batched over the gammas. the solver
+ * does not interpolate, pcc goes through per_m_det */
+enum Det_engine { SCALAR_DET, PACKED_DET, BATCHED_DET };
+
+/* matrix over the field F, see GF_element */
+template <typename F>
+class FMatrix : public Matrix<GF_element<F>>
 {
+private:
+    /* the determinant is bilinear in rows r1 and r2. returns false if
+     * the rest of the rows are linearly dependent. otherwise, w1 and w2
+     * are set s.t. det = lambda * (<u,w1><v,w2> + <u,w2><v,w1>), where
+     * u and v are the rows r1 and r2. */
+    bool cofactors(const int r1,
+                   const int r2,
+                   GF_element<F> &lambda,
+                   std::vector<GF_element<F>> &w1,
+                   std::vector<GF_element<F>> &w2) const;
+
 public:
-    using Matrix::Matrix;
+    using Matrix<GF_element<F>>::Matrix;
 
-    EMatrix lift() const;
+    EMatrix<F> lift() const;
 
     /* multiply diagonal by e. merge this with lift, so
      * that only one new copy is created? lift gets always
      * called after this */
-    EMatrix mul_diag_lift(const GF_element &e) const;
+    EMatrix<F> mul_diag_lift(const GF_element<F> &e) const;
 
-    void mul_gamma(const int r1, const int r2, const GF_element &gamma);
+    void mul_gamma(const int r1, const int r2, const GF_element<F> &gamma);
 
     void swap_rows(const int r1, const int r2, const int idx = 0);
 
+    /* small_det up to SMALL_DET_MAX rows, det_elimination otherwise */
+    GF_element<F> det();
+
     /* uses gaussian elimination with pivoting.
      * modifies the object it is called on. */
-    GF_element det();
+    GF_element<F> det_elimination();
 
     /* det of the matrix we get when r1 is multiplied by monomials
      * (1,r,..,r^(n-1)) and r2 by monomials (r^(n-1),..,r,1) */
-    Polynomial pdet(int r1, int r2) const;
+    Polynomial<F> pdet(int r1, int r2) const;
+
+    /* same as above, but computed by evaluating 2n-1 determinants
+     * and interpolating */
+    Polynomial<F> pdet_interpolation(int r1,
+                                     int r2,
+                                     Det_engine engine = BATCHED_DET,
+                                     Interpolation_mode mode = SUBSPACE_POINTS) const;
+
+    /* with the points of a plan of size 2n-1. the plan can be
+     * shared by all the calls with the same n */
+    Polynomial<F> pdet_interpolation(int r1,
+                                     int r2,
+                                     const Interpolation_plan<F> &plan,
+                                     Det_engine engine = BATCHED_DET) const;
+
+    /* sum of the coefficients of pdet(r1, r2) with degree < n */
+    GF_element<F> pdet_low_sum(int r1, int r2) const;
 
     /* return pcc_{n-1} of the matrix we get when we
      * multiply the diagonal of this matrix by e */
-    GF_element pcc(const GF_element &e) const;
+    GF_element<F> pcc(const GF_element<F> &e) const;
 };
 
 #endif
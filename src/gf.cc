@@ -1,10 +1,8 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <stdint.h>
 #include <iostream>
-#include <unordered_set>
 
 #include "gf.hh"
-#include "extension.hh"
 #include "global.hh"
 
 using namespace std;
@@ -12,11 +10,18 @@ using namespace std;
 GF2_n::GF2_n(const int &e, const uint64_t &g): n(e), mod(g)
 {
     this->mask = (1ll << this->n) - 1;
-    if (this->n != 16 && this->n != 32)
-    {
-        this->q_plus = this->quo(1ull << (2*this->n), mod);
-        this->mod_ast = this->mask & mod;
-    }
+    this->mod_ast = this->mask & mod;
+    /* x^2n = x^n * mod + x^n * mod_ast, x^2n does not fit for n = 32 */
+    this->q_plus = (1ull << this->n) ^ this->quo(this->mod_ast << this->n, mod);
+
+    /* hi has degree <= n - 2, so bits below 2 in q_plus vanish */
+    for (int i = 2; i <= this->n; i++)
+        if ((this->q_plus >> i) & 1)
+            this->q_shifts.push_back(this->n - i);
+
+    for (int i = 0; i < this->n; i++)
+        if ((this->mod_ast >> i) & 1)
+            this->mod_shifts.push_back(i);
 
     if (global::output)
     {
@@ -54,14 +59,14 @@ uint64_t GF2_n::quo(uint64_t a, const uint64_t b) const
 /* returns s s.t. for some t: s*a + t*field.mod = gcd(field.mod, a)
  * <=> s*a + t*field.mod = 1 taking mod field.mod we get
  * s*a = 1 mod field.mod and thus a^-1 = s mod field.mod*/
-uint64_t GF2_n::ext_euclid(const uint64_t a) const
+uint64_t GF2_n::ext_euclid(const uint64_t a, const uint64_t mod)
 {
     // assert(a != 0)
     uint64_t s0 = 1;
     uint64_t s1 = 0;
 
     uint64_t r0 = a;
-    uint64_t r1 = this->mod;
+    uint64_t r1 = mod;
 
     /* invariants (t0/t1 not computed):
      * x^{shift}*r0 = a*s0 + b*t0
@@ -99,73 +104,33 @@ uint64_t GF2_n::ext_euclid(const uint64_t a) const
     for (int i = 0; i < shift; i++)
     {
         if ((s0 & 1) == 1)
-            s0 ^= this->mod;
+            s0 ^= mod;
         s0 >>= 1;
     }
 
     return s0;
 }
 
-/* returns r s.t. for some q,
- * a = q*field.mod + r is the division relation (in Z(2^n))
- */
-uint64_t GF2_n::rem(const uint64_t a) const
+uint64_t GF2_n::itoh_tsujii(const uint64_t a) const
 {
-    const uint64_t lo = a & this->mask;
-    const uint64_t hi = a >> this->n;
-
-    uint64_t r = this->clmul(hi, this->q_plus);
-    r >>= this->n;
-    r = this->clmul(r, this->mod_ast);
-    r &= this->mask;
-    return r ^ lo;
-}
-
-uint64_t GF2_16::rem(const uint64_t a) const
-{
-    const uint64_t lo = a & 0xFFFF;
-    const uint64_t hi = a >> 16;
-
-    uint64_t r = hi ^ (hi >> 14) ^ (hi >> 13) ^ (hi >> 11);
-    r ^= (r << 2) ^ (r << 3) ^ (r << 5);
-    r &= 0xFFFF;
-    return r ^ lo;
-}
-
-uint64_t GF2_32::rem(const uint64_t a) const
-{
-    const uint64_t lo = a & 0xFFFFFFFF;
-    const uint64_t hi = a >> 32;
-
-    uint64_t r = hi ^ (hi >> 30) ^ (hi >> 29) ^ (hi >> 25);
-    r ^= (r << 2) ^ (r << 3) ^ (r << 7);
-    r &= 0xFFFFFFFF;
-    return r ^ lo;
-}
-
-GR_element GF_element::lift() const
-{
-    return GR_element(0x0, this->repr);
-}
-
-namespace util
-{
-    /* returns n distinct random elements from
-     * global::F-> (use LSFR?) */
-    std::vector<GF_element> distinct_elements(const int n)
+    /* b = a^(2^k - 1), k follows the bits of n - 1 from the top */
+    const int m = this->n - 1;
+    uint64_t b = a;
+    int k = 1;
+    for (int bit = 62 - __builtin_clzll(m); bit >= 0; bit--)
     {
-        std::vector<GF_element> vec(n);
-        std::unordered_set<uint64_t> have;
-        for (int i = 0; i < n; i++)
+        /* a^(2^2k - 1) = (a^(2^k - 1))^(2^k) a^(2^k - 1) */
+        uint64_t t = b;
+        for (int i = 0; i < k; i++)
+            t = this->sqr(t);
+        b = this->rem(this->clmul(t, b));
+        k *= 2;
+
+        if ((m >> bit) & 1)
         {
-            GF_element e = util::GF_random();
-            while (have.count(e.get_repr()) == 1)
-                e = util::GF_random();
-            vec[i] = e;
-            have.insert(e.get_repr());
+            b = this->rem(this->clmul(this->sqr(b), a));
+            k++;
         }
-        return vec;
     }
-
-
+    return this->sqr(b);
 }
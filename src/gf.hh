@@ -7,13 +7,18 @@
 #include <iostream>
 #include <immintrin.h>
 #include <set>
+#include <unordered_set>
+#include <cassert>
+#include <vector>
+#include <utility>
 
 #include "global.hh"
 #include "util.hh"
 
-/* forward declare */
-class GF_element;
-class GR_element;
+/* forward declare, in extension.hh */
+template <int N, uint64_t MOD> struct GR4;
+struct GR4_generic;
+template <typename R> class GR_element;
 
 /* GF(2^n) */
 class GF2_n
@@ -29,6 +34,12 @@ private:
     uint64_t q_plus;
     uint64_t mod_ast;
 
+    /* for the packed multiplications. (hi * q_plus) >> n is the sum of
+     * hi >> s for s in q_shifts and the product with mod_ast the
+     * sum of q << s for s in mod_shifts */
+    std::vector<int> q_shifts;
+    std::vector<int> mod_shifts;
+
     /* returns q s.t. for some r,
      * a = q*b + r is the division relation
      */
@@ -37,12 +48,18 @@ private:
 public:
     GF2_n(const int &e, const uint64_t &g);
 
-    uint64_t ext_euclid(const uint64_t a) const;
+    /* inverse of a modulo mod */
+    static uint64_t ext_euclid(const uint64_t a, const uint64_t mod);
+
+    inline uint64_t ext_euclid(const uint64_t a) const
+    {
+        return ext_euclid(a, this->mod);
+    }
 
     /* carryless multiplication of a and b, polynomial multiplicatoin that is
      * done with Intel CLMUL
      */
-    inline uint64_t clmul(const uint64_t a, const uint64_t b) const
+    static inline uint64_t clmul(const uint64_t a, const uint64_t b)
     {
         const __m128i prod = _mm_clmulepi64_si128(
             _mm_set_epi64x(0, a),
@@ -54,11 +71,34 @@ public:
         return _mm_extract_epi64(prod, 0x0);
     }
 
-    virtual uint64_t rem(const uint64_t a) const;
+    /* carryless square, the bits of a spread to the even positions */
+    inline uint64_t sqr(const uint64_t a) const
+    {
+        return this->rem(_pdep_u64(a, 0x5555555555555555ull));
+    }
 
-    /* multiply 8 bitsliced GF2_16 elements in one 256-bit vector.
-     * define here for inlining and avoiding overhead from virtual func. */
-    inline __m256i wide_mul(const __m256i &a, const __m256i &b) const
+    /* a^-1 = a^(2^n - 2) with an addition chain for 2^(n-1) - 1
+     * (itoh-tsujii). the operations depend only on n, zero goes to zero */
+    uint64_t itoh_tsujii(const uint64_t a) const;
+
+    /* returns r s.t. for some q,
+     * a = q*field.mod + r is the division relation (in Z(2^n)).
+     * the fields of GF2<N, MOD> below reduce without reading these */
+    inline uint64_t rem(const uint64_t a) const
+    {
+        const uint64_t lo = a & this->mask;
+        const uint64_t hi = a >> this->n;
+
+        uint64_t r = this->clmul(hi, this->q_plus);
+        r >>= this->n;
+        r = this->clmul(r, this->mod_ast);
+        r &= this->mask;
+        return r ^ lo;
+    }
+
+    /* carryless multiplication of 8 elements of at most 16 bits
+     * in 32-bit lanes. the products fit in the lanes. */
+    inline __m256i wide_clmul(const __m256i &a, const __m256i &b) const
     {
         const __m128i prodlo = _mm_blend_epi32(
             _mm_shuffle_epi32(
@@ -100,8 +140,91 @@ public:
             0x3
             );
 
-        const __m256i prod = _mm256_set_m128i(prodhi, prodlo);
+        return _mm256_set_m128i(prodhi, prodlo);
+    }
+
+    /* carryless multiplication of 4 elements of at most 32 bits
+     * in 64-bit lanes. the products fit in the lanes. */
+    inline __m256i wide_clmul_64(const __m256i &a, const __m256i &b) const
+    {
+        const __m128i alo = _mm256_extractf128_si256(a, 0);
+        const __m128i blo = _mm256_extractf128_si256(b, 0);
+        const __m128i ahi = _mm256_extractf128_si256(a, 1);
+        const __m128i bhi = _mm256_extractf128_si256(b, 1);
+
+        const __m128i prodlo = _mm_unpacklo_epi64(
+            _mm_clmulepi64_si128(alo, blo, 0x00),
+            _mm_clmulepi64_si128(alo, blo, 0x11)
+            );
+        const __m128i prodhi = _mm_unpacklo_epi64(
+            _mm_clmulepi64_si128(ahi, bhi, 0x00),
+            _mm_clmulepi64_si128(ahi, bhi, 0x11)
+            );
+
+        return _mm256_set_m128i(prodhi, prodlo);
+    }
+
+    /* spreads the bits of the low half of each lane of l bytes to the
+     * even positions, the carryless square of the low half. gather
+     * moves the low halves to the low 8 bytes of both 128-bit halves */
+    static inline __m256i wide_spread(const __m256i &a, const __m256i &gather)
+    {
+        /* spread of each nibble */
+        const __m256i table = _mm256_setr_epi8(
+            0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+            0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55,
+            0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+            0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55
+            );
+        const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+        const __m256i low = _mm256_shuffle_epi8(a, gather);
+        const __m256i lo = _mm256_shuffle_epi8(
+            table,
+            _mm256_and_si256(low, nibble)
+            );
+        const __m256i hi = _mm256_shuffle_epi8(
+            table,
+            _mm256_and_si256(_mm256_srli_epi16(low, 4), nibble)
+            );
+        return _mm256_unpacklo_epi8(lo, hi);
+    }
+
+    /* carryless squares of 8 elements of at most 16 bits in 32-bit lanes */
+    static inline __m256i wide_clsqr(const __m256i &a)
+    {
+        const __m256i gather = _mm256_setr_epi8(
+            0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+            0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1
+            );
+        return wide_spread(a, gather);
+    }
+
+    /* carryless squares of 4 elements of at most 32 bits in 64-bit lanes */
+    static inline __m256i wide_clsqr_64(const __m256i &a)
+    {
+        const __m256i gather = _mm256_setr_epi8(
+            0, 1, 2, 3, 8, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1,
+            0, 1, 2, 3, 8, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1
+            );
+        return wide_spread(a, gather);
+    }
+
+    /* multiply 8 bitsliced GF2_16 elements in one 256-bit vector.
+     * define here for inlining and avoiding overhead from virtual func. */
+    inline __m256i wide_mul(const __m256i &a, const __m256i &b) const
+    {
+        return this->wide_rem(this->wide_clmul(a, b));
+    }
+
+    inline __m256i wide_sqr(const __m256i &a) const
+    {
+        return this->wide_rem(wide_clsqr(a));
+    }
 
+    /* reduces the products of wide_clmul in GF2_16 */
+    inline __m256i wide_rem(const __m256i &prod) const
+    {
         const __m256i lomask = _mm256_set1_epi32(0xFFFF);
 
         const __m256i lo = _mm256_and_si256(
@@ -138,27 +261,261 @@ public:
         return _mm256_xor_si256(rem_hi, lo);
     }
 
+    /* multiply 4 GF2_32 elements in 64-bit lanes */
+    inline __m256i wide_mul_32(const __m256i &a, const __m256i &b) const
+    {
+        return this->wide_rem_32(this->wide_clmul_64(a, b));
+    }
+
+    inline __m256i wide_sqr_32(const __m256i &a) const
+    {
+        return this->wide_rem_32(wide_clsqr_64(a));
+    }
+
+    /* reduces the products of wide_clmul_64 in GF2_32 */
+    inline __m256i wide_rem_32(const __m256i &prod) const
+    {
+        const __m256i lo = _mm256_and_si256(
+            prod,
+            _mm256_set1_epi64x(0xFFFFFFFF)
+            );
+        const __m256i hi = _mm256_srli_epi64(prod, 32);
+
+        const __m256i tmp = _mm256_xor_si256(
+            hi,
+            _mm256_xor_si256(
+                _mm256_srli_epi64(hi, 30),
+                _mm256_xor_si256(
+                    _mm256_srli_epi64(hi, 29),
+                    _mm256_srli_epi64(hi, 25)
+                    )
+                )
+            );
+
+        const __m256i rem_hi = _mm256_xor_si256(
+            tmp,
+            _mm256_xor_si256(
+                _mm256_slli_epi64(tmp, 2),
+                _mm256_xor_si256(
+                    _mm256_slli_epi64(tmp, 3),
+                    _mm256_slli_epi64(tmp, 7)
+                    )
+                )
+            );
+
+        return _mm256_xor_si256(
+            _mm256_and_si256(rem_hi, _mm256_set1_epi64x(0xFFFFFFFF)),
+            lo
+            );
+    }
+
+    /* multiply 8 elements in 32-bit lanes, n <= 16. the reduction is the
+     * same as in rem, but the carryless multiplications by q_plus and
+     * mod_ast are done with the shifts given by their bits. */
+    inline __m256i wide_mul_n(const __m256i &a, const __m256i &b) const
+    {
+        return this->wide_rem_n(this->wide_clmul(a, b));
+    }
+
+    inline __m256i wide_sqr_n(const __m256i &a) const
+    {
+        return this->wide_rem_n(wide_clsqr(a));
+    }
+
+    /* reduces the products of wide_clmul, n <= 16 */
+    inline __m256i wide_rem_n(const __m256i &prod) const
+    {
+        const __m256i mask = _mm256_set1_epi32(this->mask);
+
+        const __m256i lo = _mm256_and_si256(prod, mask);
+        const __m256i hi = _mm256_srli_epi32(prod, this->n);
+
+        __m256i q = _mm256_setzero_si256();
+        for (uint i = 0; i < this->q_shifts.size(); i++)
+            q = _mm256_xor_si256(q, _mm256_srli_epi32(hi, this->q_shifts[i]));
+
+        __m256i r = _mm256_setzero_si256();
+        for (uint i = 0; i < this->mod_shifts.size(); i++)
+            r = _mm256_xor_si256(r, _mm256_slli_epi32(q, this->mod_shifts[i]));
+
+        return _mm256_xor_si256(_mm256_and_si256(r, mask), lo);
+    }
+
+    /* multiply 4 elements in 64-bit lanes, n <= 32. see wide_mul_n */
+    inline __m256i wide_mul_n_64(const __m256i &a, const __m256i &b) const
+    {
+        return this->wide_rem_n_64(this->wide_clmul_64(a, b));
+    }
+
+    inline __m256i wide_sqr_n_64(const __m256i &a) const
+    {
+        return this->wide_rem_n_64(wide_clsqr_64(a));
+    }
+
+    /* reduces the products of wide_clmul_64, n <= 32 */
+    inline __m256i wide_rem_n_64(const __m256i &prod) const
+    {
+        const __m256i mask = _mm256_set1_epi64x(this->mask);
+
+        const __m256i lo = _mm256_and_si256(prod, mask);
+        const __m256i hi = _mm256_srli_epi64(prod, this->n);
+
+        __m256i q = _mm256_setzero_si256();
+        for (uint i = 0; i < this->q_shifts.size(); i++)
+            q = _mm256_xor_si256(q, _mm256_srli_epi64(hi, this->q_shifts[i]));
+
+        __m256i r = _mm256_setzero_si256();
+        for (uint i = 0; i < this->mod_shifts.size(); i++)
+            r = _mm256_xor_si256(r, _mm256_slli_epi64(q, this->mod_shifts[i]));
+
+        return _mm256_xor_si256(_mm256_and_si256(r, mask), lo);
+    }
+
     inline int get_n() const { return this->n; }
     inline uint64_t get_mod() const { return this->mod; }
     inline uint64_t get_mask() const { return this->mask; }
 };
 
-class GF2_16 : public GF2_n
+/* GF(2^N) with the modulus fixed at compile time. the Barrett constants
+ * and their shifts are generated from MOD, so rem is a fixed sequence of
+ * shifts and xors. GF_element and its users take the field as a type
+ * with these static functions, see GF2_generic for the other fields */
+template <int N, uint64_t MOD>
+struct GF2
 {
-public:
-    using GF2_n::GF2_n;
+    /* the Galois ring that lifts the field */
+    typedef GR4<N, MOD> Ring;
+
+    static constexpr uint64_t MASK = (1ull << N) - 1;
+    static constexpr uint64_t MOD_AST = MOD & MASK;
 
-    uint64_t rem(const uint64_t a) const override;
+    /* quotient of x^2N by MOD */
+    static constexpr uint64_t q_plus()
+    {
+        /* x^2N = x^N * MOD + x^N * MOD_AST */
+        uint64_t a = MOD_AST << N;
+        uint64_t q = 0;
+        while (a >> N)
+        {
+            int deg = 63;
+            while (!((a >> deg) & 1))
+                deg--;
+            q ^= 1ull << (deg - N);
+            a ^= MOD << (deg - N);
+        }
+        return (1ull << N) ^ q;
+    }
+
+    static constexpr uint64_t Q_PLUS = q_plus();
+
+    /* hi has degree <= N - 2, so bits below 2 in Q_PLUS vanish */
+    static constexpr int Q_COUNT = __builtin_popcountll(Q_PLUS >> 2);
+    static constexpr int MOD_COUNT = __builtin_popcountll(MOD_AST);
+
+    struct Shifts
+    {
+        int q[Q_COUNT > 0 ? Q_COUNT : 1];
+        int mod[MOD_COUNT > 0 ? MOD_COUNT : 1];
+    };
+
+    static constexpr Shifts shifts()
+    {
+        Shifts s = { };
+        int k = 0;
+        for (int i = N; i >= 2; i--)
+            if ((Q_PLUS >> i) & 1)
+                s.q[k++] = N - i;
+        k = 0;
+        for (int i = 0; i < N; i++)
+            if ((MOD_AST >> i) & 1)
+                s.mod[k++] = i;
+        return s;
+    }
+
+    static constexpr Shifts SHIFTS = shifts();
+
+    template <std::size_t... I>
+    static inline uint64_t quo_hi(const uint64_t hi, std::index_sequence<I...>)
+    {
+        return (0ull ^ ... ^ (hi >> SHIFTS.q[I]));
+    }
+
+    template <std::size_t... I>
+    static inline uint64_t mul_ast(const uint64_t q, std::index_sequence<I...>)
+    {
+        return (0ull ^ ... ^ (q << SHIFTS.mod[I]));
+    }
+
+    static inline uint64_t rem(const uint64_t a)
+    {
+        const uint64_t lo = a & MASK;
+        const uint64_t hi = a >> N;
+
+        const uint64_t q = quo_hi(hi, std::make_index_sequence<Q_COUNT>());
+        const uint64_t r = mul_ast(q, std::make_index_sequence<MOD_COUNT>());
+        return (r & MASK) ^ lo;
+    }
+
+    static inline uint64_t clmul(const uint64_t a, const uint64_t b)
+    {
+        return GF2_n::clmul(a, b);
+    }
+
+    static inline uint64_t sqr(const uint64_t a)
+    {
+        return rem(_pdep_u64(a, 0x5555555555555555ull));
+    }
+
+    static inline uint64_t ext_euclid(const uint64_t a)
+    {
+        return GF2_n::ext_euclid(a, MOD);
+    }
+
+    static constexpr int get_n() { return N; }
+    static constexpr uint64_t get_mod() { return MOD; }
+    static constexpr uint64_t get_mask() { return MASK; }
 };
 
-class GF2_32 : public GF2_n
+/* the fields that have a compiled reduction */
+/* x^16 + x^5 + x^3 + x^2 +  1 */
+typedef GF2<16, 0x1002D> GF2_16;
+/* x^32 + x^7 + x^3 + x^2 + 1 */
+typedef GF2<32, 0x10000008D> GF2_32;
+
+/* any other field, the same functions as GF2<N, MOD> with
+ * the modulus and the constants of global::F */
+struct GF2_generic
 {
-public:
-    using GF2_n::GF2_n;
+    typedef GR4_generic Ring;
+
+    static inline uint64_t rem(const uint64_t a)
+    {
+        return global::F->rem(a);
+    }
+
+    static inline uint64_t clmul(const uint64_t a, const uint64_t b)
+    {
+        return GF2_n::clmul(a, b);
+    }
+
+    static inline uint64_t sqr(const uint64_t a)
+    {
+        return global::F->sqr(a);
+    }
 
-    uint64_t rem(const uint64_t a) const override;
+    static inline uint64_t ext_euclid(const uint64_t a)
+    {
+        return global::F->ext_euclid(a);
+    }
+
+    static inline int get_n() { return global::F->get_n(); }
+    static inline uint64_t get_mod() { return global::F->get_mod(); }
+    static inline uint64_t get_mask() { return global::F->get_mask(); }
 };
 
+/* element of the field F, one of the field types above. the
+ * arithmetic is the static functions of F, inlined at each use */
+template <typename F>
 class GF_element
 {
 private:
@@ -184,36 +541,41 @@ public:
 
     inline GF_element operator*(const GF_element &other) const
     {
-        const uint64_t prod = global::F->clmul(
+        const uint64_t prod = F::clmul(
             this->repr,
             other.get_repr()
             );
 
         return GF_element(
-            global::F->rem(prod)
+            F::rem(prod)
             );
     }
 
     inline GF_element &operator*=(const GF_element &other)
     {
-        const uint64_t prod = global::F->clmul(
+        const uint64_t prod = F::clmul(
             this->repr,
             other.get_repr()
             );
 
-        this->repr = global::F->rem(prod);
+        this->repr = F::rem(prod);
 
         return *this;
     }
 
+    inline GF_element square() const
+    {
+        return GF_element(F::sqr(this->repr));
+    }
+
     inline GF_element inv() const
     {
-        return GF_element(global::F->ext_euclid(this->repr));
+        return GF_element(F::ext_euclid(this->repr));
     }
 
     inline void inv_in_place()
     {
-        this->repr = global::F->ext_euclid(this->repr);
+        this->repr = F::ext_euclid(this->repr);
     }
 
     inline GF_element operator/(const GF_element &other) const
@@ -223,13 +585,13 @@ public:
 
     inline GF_element &operator/=(const GF_element &other)
     {
-        const uint64_t inv_repr = global::F->ext_euclid(other.get_repr());
-        const uint64_t prod = global::F->clmul(
+        const uint64_t inv_repr = F::ext_euclid(other.get_repr());
+        const uint64_t prod = F::clmul(
             this->repr,
             inv_repr
             );
 
-        this->repr = global::F->rem(prod);
+        this->repr = F::rem(prod);
         return *this;
     }
 
@@ -267,7 +629,8 @@ public:
         return this->repr > other.get_repr();
     }
 
-    GR_element lift() const;
+    /* in extension.hh */
+    GR_element<typename F::Ring> lift() const;
 
     void print() const
     {
@@ -277,22 +640,91 @@ public:
 
 namespace util
 {
-    std::vector<GF_element> distinct_elements(const int n);
-
-    inline GF_element GF_zero()
+    template <typename F>
+    inline GF_element<F> GF_zero()
     {
-        return GF_element(0);
+        return GF_element<F>(0);
     }
 
-    inline GF_element GF_one()
+    template <typename F>
+    inline GF_element<F> GF_one()
     {
-        return GF_element(1);
+        return GF_element<F>(1);
     }
 
     /* this can create zero, is it a problem? */
-    inline GF_element GF_random()
+    template <typename F>
+    inline GF_element<F> GF_random()
+    {
+        return GF_element<F>(global::randgen() & F::get_mask());
+    }
+
+    /* returns n distinct random elements from
+     * F (use LSFR?). n <= 2^n of the field */
+    template <typename F>
+    std::vector<GF_element<F>> distinct_elements(const int n)
+    {
+        assert(n <= (1ll << F::get_n()));
+        std::vector<GF_element<F>> vec(n);
+        std::unordered_set<uint64_t> have;
+        for (int i = 0; i < n; i++)
+        {
+            GF_element<F> e = util::GF_random<F>();
+            while (have.count(e.get_repr()) == 1)
+                e = util::GF_random<F>();
+            vec[i] = e;
+            have.insert(e.get_repr());
+        }
+        return vec;
+    }
+
+    /* 0, 1, .., n-1, the first n elements of the
+     * subspace spanned by 1, x, x^2, .. n <= 2^n of the field */
+    template <typename F>
+    std::vector<GF_element<F>> subspace_elements(const int n)
+    {
+        assert(n <= (1ll << F::get_n()));
+        std::vector<GF_element<F>> vec(n);
+        for (int i = 0; i < n; i++)
+            vec[i] = GF_element<F>(i);
+        return vec;
+    }
+
+    /* inverts the n elements of a in place with one inversion and
+     * 3(n-1) multiplications (montgomery's trick). zeros stay zero */
+    template <typename F>
+    void batch_inverse(GF_element<F> *a, const int n)
+    {
+        if (n == 0)
+            return;
+        /* prefix[i] is the product of the nonzero a[0..i] */
+        std::vector<GF_element<F>> prefix(n);
+        GF_element<F> acc = GF_one<F>();
+        for (int i = 0; i < n; i++)
+        {
+            if (a[i] != GF_zero<F>())
+                acc *= a[i];
+            prefix[i] = acc;
+        }
+
+        /* inverse of the product of the nonzero a[0..i] */
+        GF_element<F> inv = acc.inv();
+        for (int i = n - 1; i > 0; i--)
+        {
+            if (a[i] == GF_zero<F>())
+                continue;
+            const GF_element<F> e = inv * prefix[i - 1];
+            inv *= a[i];
+            a[i] = e;
+        }
+        if (a[0] != GF_zero<F>())
+            a[0] = inv;
+    }
+
+    template <typename F>
+    inline void batch_inverse(std::vector<GF_element<F>> &a)
     {
-        return GF_element(global::randgen() & global::F->get_mask());
+        batch_inverse(a.data(), a.size());
     }
 }
 
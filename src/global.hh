@@ -2,6 +2,9 @@
 #ifndef GLOBAL_H
 #define GLOBAL_H
 
+#include <cstdint>
+#include <atomic>
+
 #include "xorshift.hh"
 
 class GF2_n;
@@ -9,21 +12,59 @@ class GR4_n;
 
 namespace util
 {
+    /* seed for the index from seed (splitmix64), different indices
+     * give unrelated seeds */
+    inline uint64_t mix_seed(const uint64_t seed, const uint64_t index)
+    {
+        uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
     class rand64bit
     {
     private:
         Xorshift gen;
+        bool seeded;
+        /* a generator that draws before init is seeded from base and
+         * the order in which the unseeded ones start drawing */
+        static inline std::atomic<uint64_t> base{0};
+        static inline std::atomic<uint64_t> unseeded{0};
+
     public:
-        rand64bit() {}
-        void init(uint64_t seed) { this->gen.init(seed); }
-        uint64_t operator()() { return this->gen.next(); }
+        rand64bit(): seeded(false) {}
+
+        /* xorshift stays at zero from a zero state */
+        void init(const uint64_t seed)
+        {
+            this->gen.init((seed) ? seed : 0x9E3779B97F4A7C15ull);
+            this->seeded = true;
+        }
+
+        /* init, and the base for the generators of the other threads */
+        void init_all(const uint64_t seed)
+        {
+            base.store(seed);
+            this->init(seed);
+        }
+
+        uint64_t operator()()
+        {
+            if (!this->seeded)
+                this->init(mix_seed(base.load(), unseeded.fetch_add(1)));
+            return this->gen.next();
+        }
     };
 }
 
 namespace global
 {
     /* these are defined in main.cc. no writing, just reading. */
-    extern util::rand64bit randgen;
+    /* each thread draws from its own generator. main seeds its own
+     * with init_all, the batch mode seeds it for each graph and the
+     * other threads derive a seed when they first draw */
+    extern thread_local util::rand64bit randgen;
     extern GF2_n *F;
     extern GR4_n *E;
     extern bool output;
@@ -1,7 +1,7 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <iostream>
 #include <vector>
-#include <valarray>
+#include <utility>
 
 #include "global.hh"
 #include "graph.hh"
@@ -9,57 +9,259 @@
 
 using namespace std;
 
-Graph::Graph(vector<vector<int>> &adjacency_list): A(adjacency_list.size())
+template <typename F>
+Graph<F>::Graph(CSR adjacency): n(adjacency.get_n()), A(adjacency.get_n())
 {
-    this->n = adjacency_list.size();
-    this->adj = adjacency_list;
+    this->adj = move(adjacency);
     this->sample_adjacency();
 
     if (global::output)
         cout << "created graph of " << this->n << " vertices:" << endl;
 }
 
+template <typename F>
+Graph<F>::Graph(const vector<vector<int>> &adjacency_list):
+    Graph(CSR(adjacency_list))
+{
+}
+
 /* samples the adjacency matrix with random edge weights from F
+ * straight to A, which is zero initialized.
  * also creates a loop at each vertex
  */
-void Graph::sample_adjacency()
+template <typename F>
+void Graph<F>::sample_adjacency()
 {
-    valarray<GF_element> m(util::GF_zero(), this->n * this->n);
-
     for (int u = 0; u < this->n; u++)
     {
         /* loop at each vertex */
-        m[u*this->n + u] = util::GF_random();
-        for (uint i = 0; i < this->adj[u].size(); i++)
+        this->A.set(u, u, util::GF_random<F>());
+        for (const int *v = this->adj.begin(u); v != this->adj.end(u); v++)
+            this->A.set(u, *v, util::GF_random<F>());
+    }
+}
+
+/* iterative version of Tarjan's algorithm */
+template <typename F>
+vector<vector<int>> Graph<F>::strongly_connected_components() const
+{
+    vector<vector<int>> comps;
+    vector<int> index(this->n, -1);
+    vector<int> low(this->n);
+    vector<bool> on_stack(this->n, false);
+    vector<int> stack;
+    /* vertex and the index of the next neighbor to visit */
+    vector<pair<int,int>> call;
+    int counter = 0;
+
+    for (int s = 0; s < this->n; s++)
+    {
+        if (index[s] != -1)
+            continue;
+
+        call.push_back({ s, 0 });
+        index[s] = low[s] = counter++;
+        stack.push_back(s);
+        on_stack[s] = true;
+
+        while (!call.empty())
         {
-            const int v = this->adj[u][i];
-            m[u*this->n + v] = util::GF_random();
+            const int v = call.back().first;
+            const int i = call.back().second;
+
+            if (i < this->adj.degree(v))
+            {
+                call.back().second++;
+                const int u = this->adj(v, i);
+                if (index[u] == -1)
+                {
+                    index[u] = low[u] = counter++;
+                    stack.push_back(u);
+                    on_stack[u] = true;
+                    call.push_back({ u, 0 });
+                }
+                else if (on_stack[u])
+                    low[v] = min(low[v], index[u]);
+                continue;
+            }
+
+            call.pop_back();
+            if (!call.empty())
+            {
+                const int parent = call.back().first;
+                low[parent] = min(low[parent], low[v]);
+            }
+
+            if (low[v] == index[v])
+            {
+                vector<int> comp;
+                int u;
+                do
+                {
+                    u = stack.back();
+                    stack.pop_back();
+                    on_stack[u] = false;
+                    comp.push_back(u);
+                } while (u != v);
+                comps.push_back(comp);
+            }
         }
     }
 
-    this->A.copy(FMatrix(this->n, m));
-    return;
+    return comps;
 }
 
-/* goes through all cycles that contain vertex start
- * and updates len accordingly.
- * len contains the length of the shortest found so far */
-int Graph::dfs_cycle(const int start,
-                     const int depth,
-                     const int v,
-                     vector<bool> &visited,
-                     int len) const
+template <typename F>
+Graph<F> Graph<F>::induced_subgraph(const vector<int> &vertices) const
 {
-    visited[v] = true;
-    vector<int> nbors = this->adj[v];
-    for (uint i = 0; i < nbors.size(); i++)
+    vector<int> label(this->n, -1);
+    for (uint i = 0; i < vertices.size(); i++)
+        label[vertices[i]] = i;
+
+    CSR sub;
+    sub.offsets.resize(vertices.size() + 1);
+    for (uint i = 0; i < vertices.size(); i++)
     {
-        int u = nbors[i];
-        if (!visited[u])
-            len = this->dfs_cycle(start, depth + 1, u, visited, len);
-        else if (u == start && depth % 2 == 0 && depth < len)
-            len = depth;
+        for (const int *v = this->adj.begin(vertices[i]);
+             v != this->adj.end(vertices[i]); v++)
+        {
+            if (label[*v] != -1)
+                sub.targets.push_back(label[*v]);
+        }
+        sub.offsets[i + 1] = sub.targets.size();
     }
-    visited[v] = false;
-    return len;
+
+    return Graph<F>(move(sub));
+}
+
+/* visited sets of the search. one word is enough when n <= 64 */
+struct Mask_64
+{
+    uint64_t w = 0;
+
+    explicit Mask_64(const int) {}
+    inline bool test(const int v) const { return (this->w >> v) & 1; }
+    inline void set(const int v) { this->w |= 1ull << v; }
+    inline void reset(const int v) { this->w &= ~(1ull << v); }
+};
+
+struct Mask_n
+{
+    vector<uint64_t> w;
+
+    explicit Mask_n(const int n): w((n + 63) / 64) {}
+    inline bool test(const int v) const { return (this->w[v / 64] >> (v % 64)) & 1; }
+    inline void set(const int v) { this->w[v / 64] |= 1ull << (v % 64); }
+    inline void reset(const int v) { this->w[v / 64] &= ~(1ull << (v % 64)); }
+};
+
+/* len = min(len, l) */
+static void lower(atomic<int> &len, const int l)
+{
+    int cur = len.load(memory_order_relaxed);
+    while (l < cur && !len.compare_exchange_weak(cur, l))
+        ;
 }
+
+/* iterative depth first search over the simple paths from start through
+ * vertices larger than start. a path is not extended if even the
+ * shortest way back to start can not give an even cycle shorter than len */
+template <typename Mask>
+static void search(const CSR &adj,
+                   const CSR &radj,
+                   const int start,
+                   atomic<int> &len)
+{
+    const int n = adj.get_n();
+
+    /* dist[v] is the distance from v to start through vertices larger
+     * than start, -1 if there is no such path. bfs on the reverse graph */
+    vector<int> dist(n, -1);
+    vector<int> queue = { start };
+    dist[start] = 0;
+    for (uint i = 0; i < queue.size(); i++)
+    {
+        const int v = queue[i];
+        for (const int *u = radj.begin(v); u != radj.end(v); u++)
+        {
+            if (*u > start && dist[*u] == -1)
+            {
+                dist[*u] = dist[v] + 1;
+                queue.push_back(*u);
+            }
+        }
+    }
+
+    Mask visited(n);
+    /* the path and the index of the next neighbour of each vertex */
+    vector<int> path = { start };
+    vector<uint> next = { 0 };
+    visited.set(start);
+    while (!path.empty())
+    {
+        const int v = path.back();
+        /* arcs on the path when extended by one */
+        const int depth = path.size();
+        if ((int) next.back() == adj.degree(v))
+        {
+            visited.reset(v);
+            path.pop_back();
+            next.pop_back();
+            continue;
+        }
+
+        const int u = adj(v, next.back()++);
+        if (u == start)
+        {
+            if (depth % 2 == 0)
+                lower(len, depth);
+            continue;
+        }
+        if (u < start || dist[u] == -1 || visited.test(u))
+            continue;
+
+        /* shortest even cycle this path can be part of */
+        const int bound = depth + dist[u] + ((depth + dist[u]) & 1);
+        if (bound >= len.load(memory_order_relaxed))
+            continue;
+
+        visited.set(u);
+        path.push_back(u);
+        next.push_back(0);
+    }
+}
+
+template <typename F>
+CSR Graph<F>::reverse() const
+{
+    CSR radj;
+    radj.offsets.assign(this->n + 1, 0);
+    radj.targets.resize(this->adj.get_m());
+
+    for (int i = 0; i < this->adj.get_m(); i++)
+        radj.offsets[this->adj.targets[i] + 1]++;
+    for (int v = 0; v < this->n; v++)
+        radj.offsets[v + 1] += radj.offsets[v];
+
+    vector<int> pos(radj.offsets.begin(), radj.offsets.end() - 1);
+    for (int u = 0; u < this->n; u++)
+        for (const int *v = this->adj.begin(u); v != this->adj.end(u); v++)
+            radj.targets[pos[*v]++] = u;
+
+    return radj;
+}
+
+template <typename F>
+void Graph<F>::even_cycle_search(const int start,
+                                 const CSR &radj,
+                                 atomic<int> &len) const
+{
+    if (this->n <= 64)
+        search<Mask_64>(this->adj, radj, start, len);
+    else
+        search<Mask_n>(this->adj, radj, start, len);
+}
+
+template class Graph<GF2_16>;
+template class Graph<GF2_32>;
+template class Graph<GF2_generic>;
@@ -2,29 +2,47 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 #include <vector>
+#include <atomic>
 
 #include "gf.hh"
 #include "fmatrix.hh"
+#include "csr.hh"
 
+/* digraph with its adjacency matrix over the field F */
+template <typename F>
 class Graph
 {
 private:
     int n;
-    std::vector<std::vector<int>> adj;
-    FMatrix A;
+    CSR adj;
+    FMatrix<F> A;
 
     void sample_adjacency();
 
 public:
-    explicit Graph(std::vector<std::vector<int>> &adjacency_list);
+    explicit Graph(CSR adjacency);
+    explicit Graph(const std::vector<std::vector<int>> &adjacency_list);
 
     inline int get_n() const { return n; }
-    inline FMatrix &get_A() { return A; }
+    inline FMatrix<F> &get_A() { return A; }
+    inline const CSR &get_adj() const { return adj; }
 
-    int dfs_cycle(const int start,
-                  const int depth,
-                  const int v,
-                  std::vector<bool> &visited,
-                  int len) const;
+    /* vertex sets of the strongly connected components */
+    std::vector<std::vector<int>> strongly_connected_components() const;
+
+    /* subgraph induced by vertices. vertices get relabeled
+     * in the order they are given */
+    Graph induced_subgraph(const std::vector<int> &vertices) const;
+
+    /* the graph with arcs reversed */
+    CSR reverse() const;
+
+    /* lowers len to the length of the shortest even cycle whose
+     * smallest vertex is start, if it is shorter. len is shared
+     * by the searches from the other vertices and used for pruning.
+     * radj is from reverse() */
+    void even_cycle_search(const int start,
+                           const CSR &radj,
+                           std::atomic<int> &len) const;
 };
 #endif
@@ -0,0 +1,352 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#ifndef L_FMATRIX_H
+#define L_FMATRIX_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <immintrin.h>
+
+#include "gf.hh"
+#include "global.hh"
+#include "fmatrix.hh"
+#include "packed_fmatrix.hh"
+#include "row_override.hh"
+
+/* pdet_low_sum of VECTOR_N independent matrices of the same size, the
+ * matrix i in lane i. small matrices do not fill a vector with their
+ * columns, so the lanes go to different matrices instead. each lane has
+ * its own r1, r2 and pivots, the rows are not swapped but pivoted
+ * rows are marked with their pivot column. W is one of the packed
+ * multiplications in packed_fmatrix.hh for the field F */
+template <typename F, typename W>
+class Lane_FMatrix
+{
+private:
+    static constexpr int VECTOR_N = W::VECTOR_N;
+
+    int n;
+    /* the similar rows of each lane */
+    long4_t r1;
+    long4_t r2;
+    std::vector<long4_t> m;
+    /* rows r1 and r2 of each lane, before the elimination */
+    std::vector<long4_t> u;
+    std::vector<long4_t> v;
+
+    const long4_t &get(const int row, const int col) const
+    {
+        return this->m[row*this->n + col];
+    }
+
+    void set(const int row, const int col, const long4_t &v)
+    {
+        this->m[row*this->n + col] = v;
+    }
+
+    static long4_t ones()
+    {
+        return _mm256_set1_epi32(-1);
+    }
+
+    static long4_t blend(const long4_t &a,
+                         const long4_t &b,
+                         const long4_t &mask)
+    {
+        return _mm256_blendv_epi8(a, b, mask);
+    }
+
+    /* sum of the elements of the row in the lanes where col equals c */
+    long4_t select_col(const int row, const long4_t &col) const
+    {
+        long4_t x = _mm256_setzero_si256();
+        for (int c = 0; c < this->n; c++)
+            x = _mm256_or_si256(x, _mm256_and_si256(
+                                    this->get(row, c),
+                                    Lanes<W>::equal(col, Lanes<W>::broadcast(c))
+                                    ));
+        return x;
+    }
+
+public:
+    /* matrices[first + i] goes to lane i with its similar rows r1 and
+     * r2 in rows[first + i]. the lanes past the end of the vectors
+     * repeat the last matrix */
+    Lane_FMatrix(const std::vector<FMatrix<F>> &matrices,
+                 const std::vector<std::pair<int, int>> &rows,
+                 const unsigned int first)
+    {
+        this->n = matrices[first].get_n();
+        this->m.resize(this->n * this->n);
+        this->u.resize(this->n);
+        this->v.resize(this->n);
+
+        uint64_t lane1[VECTOR_N];
+        uint64_t lane2[VECTOR_N];
+        const FMatrix<F> *mat[VECTOR_N];
+        for (int i = 0; i < VECTOR_N; i++)
+        {
+            const unsigned int idx =
+                std::min(first + i, (unsigned int) matrices.size() - 1);
+            mat[i] = &matrices[idx];
+            lane1[i] = rows[idx].first;
+            lane2[i] = rows[idx].second;
+        }
+        this->r1 = Lanes<W>::pack(lane1);
+        this->r2 = Lanes<W>::pack(lane2);
+
+        uint64_t elems[VECTOR_N];
+        for (int row = 0; row < this->n; row++)
+        {
+            for (int col = 0; col < this->n; col++)
+            {
+                for (int i = 0; i < VECTOR_N; i++)
+                    elems[i] = (*mat[i])(row, col).get_repr();
+                this->set(row, col, Lanes<W>::pack(elems));
+            }
+        }
+
+        for (int col = 0; col < this->n; col++)
+        {
+            for (int i = 0; i < VECTOR_N; i++)
+                elems[i] = (*mat[i])(lane1[i], col).get_repr();
+            this->u[col] = Lanes<W>::pack(elems);
+            for (int i = 0; i < VECTOR_N; i++)
+                elems[i] = (*mat[i])(lane2[i], col).get_repr();
+            this->v[col] = Lanes<W>::pack(elems);
+        }
+    }
+
+    /* same for views, rows i1 and i2 are r1 and r2. the multiples of
+     * row i1 are computed in the lanes instead of element by element */
+    Lane_FMatrix(const std::vector<Row_override<F>> &views,
+                 const unsigned int first)
+    {
+        this->n = views[first].get_n();
+        this->m.resize(this->n * this->n);
+        this->u.resize(this->n);
+        this->v.resize(this->n);
+
+        uint64_t lane1[VECTOR_N];
+        uint64_t lane2[VECTOR_N];
+        const Row_override<F> *view[VECTOR_N];
+        for (int i = 0; i < VECTOR_N; i++)
+        {
+            const unsigned int idx =
+                std::min(first + i, (unsigned int) views.size() - 1);
+            view[i] = &views[idx];
+            lane1[i] = view[i]->get_i1();
+            lane2[i] = view[i]->get_i2();
+        }
+        this->r1 = Lanes<W>::pack(lane1);
+        this->r2 = Lanes<W>::pack(lane2);
+
+        uint64_t elems[VECTOR_N];
+        const GF_element<F> *base[VECTOR_N];
+        /* row i1 of the base is row r1 of the view */
+        for (int i = 0; i < VECTOR_N; i++)
+            base[i] = view[i]->base_row(lane1[i]);
+        for (int col = 0; col < this->n; col++)
+        {
+            for (int i = 0; i < VECTOR_N; i++)
+                elems[i] = base[i][col].get_repr();
+            this->u[col] = Lanes<W>::pack(elems);
+        }
+
+        for (int row = 0; row < this->n; row++)
+        {
+            for (int i = 0; i < VECTOR_N; i++)
+                elems[i] = view[i]->get_t(row).get_repr();
+            const long4_t t = Lanes<W>::pack(elems);
+            const long4_t replaced =
+                Lanes<W>::equal(this->r2, Lanes<W>::broadcast(row));
+            const bool added = !_mm256_testz_si256(t, t);
+
+            for (int i = 0; i < VECTOR_N; i++)
+                base[i] = view[i]->base_row(row);
+            for (int col = 0; col < this->n; col++)
+            {
+                for (int i = 0; i < VECTOR_N; i++)
+                    elems[i] = base[i][col].get_repr();
+                long4_t e = _mm256_andnot_si256(replaced,
+                                                Lanes<W>::pack(elems));
+                if (added)
+                    e = _mm256_xor_si256(e, W::mul(t, this->u[col]));
+                this->set(row, col, e);
+            }
+        }
+
+        for (int col = 0; col < this->n; col++)
+        {
+            long4_t e = _mm256_setzero_si256();
+            for (int row = 0; row < this->n; row++)
+                e = _mm256_or_si256(e, _mm256_and_si256(
+                                        this->get(row, col),
+                                        Lanes<W>::equal(
+                                            this->r2,
+                                            Lanes<W>::broadcast(row))));
+            this->v[col] = e;
+        }
+    }
+
+    /* pdet_low_sum(r1, r2) of each lane to sums, see FMatrix::cofactors.
+     * gauss-jordan elimination takes the rows other than r1 and r2 to
+     * reduced row echelon form, so w1 and w2 need no back substitution.
+     * modifies the matrices */
+    void pdet_low_sums(GF_element<F> *sums)
+    {
+        const int n = this->n;
+        const long4_t none = ones();
+        const long4_t one = Lanes<W>::broadcast(0x1);
+
+        /* pivot column of each row in each lane, none if the row has
+         * no pivot yet and n at r1 and r2 */
+        std::vector<long4_t> pivcol(n);
+        for (int row = 0; row < n; row++)
+        {
+            const long4_t brow = Lanes<W>::broadcast(row);
+            pivcol[row] = blend(none, Lanes<W>::broadcast(n),
+                                _mm256_or_si256(
+                                    Lanes<W>::equal(this->r1, brow),
+                                    Lanes<W>::equal(this->r2, brow)));
+        }
+
+        /* lanes where row is the pivot row of the current column */
+        std::vector<long4_t> pick(n);
+        /* normalized pivot row */
+        std::vector<long4_t> prow(n);
+
+        long4_t c1 = none;
+        long4_t c2 = none;
+        /* lanes with more than two free columns */
+        long4_t dependent = _mm256_setzero_si256();
+        long4_t lambda = one;
+        uint64_t elems[VECTOR_N];
+
+        for (int col = 0; col < n; col++)
+        {
+            const long4_t bcol = Lanes<W>::broadcast(col);
+            long4_t missing = none;
+            for (int row = 0; row < n; row++)
+            {
+                pick[row] = _mm256_andnot_si256(
+                    Lanes<W>::zero_lanes(this->get(row, col)),
+                    _mm256_and_si256(Lanes<W>::equal(pivcol[row], none),
+                                     missing)
+                    );
+                missing = _mm256_andnot_si256(pick[row], missing);
+                pivcol[row] = blend(pivcol[row], bcol, pick[row]);
+            }
+
+            /* col is free in the missing lanes */
+            const long4_t first = _mm256_and_si256(
+                missing, Lanes<W>::equal(c1, none));
+            c1 = blend(c1, bcol, first);
+            missing = _mm256_andnot_si256(first, missing);
+            const long4_t second = _mm256_and_si256(
+                missing, Lanes<W>::equal(c2, none));
+            c2 = blend(c2, bcol, second);
+            missing = _mm256_andnot_si256(second, missing);
+            dependent = _mm256_or_si256(dependent, missing);
+            if (_mm256_testc_si256(dependent, none))
+                break;
+
+            for (int c = 0; c < n; c++)
+            {
+                prow[c] = _mm256_setzero_si256();
+                for (int row = 0; row < n; row++)
+                    prow[c] = _mm256_or_si256(prow[c], _mm256_and_si256(
+                                                  this->get(row, c),
+                                                  pick[row]));
+            }
+
+            /* lanes without a pivot continue with pivot one, the pivot
+             * row is zero in them */
+            const long4_t pivot = blend(prow[col], one,
+                                        Lanes<W>::zero_lanes(prow[col]));
+            lambda = W::mul(lambda, pivot);
+
+            const long4_t pinv = Lanes<W>::inv(pivot);
+            for (int c = 0; c < n; c++)
+                prow[c] = W::mul(prow[c], pinv);
+
+            for (int row = 0; row < n; row++)
+            {
+                if (!_mm256_testz_si256(pick[row], pick[row]))
+                    for (int c = 0; c < n; c++)
+                        this->set(row, c, blend(this->get(row, c), prow[c],
+                                                pick[row]));
+
+                /* r1 and r2 are read from u and v */
+                const long4_t f = _mm256_andnot_si256(
+                    _mm256_or_si256(pick[row],
+                                    Lanes<W>::equal(pivcol[row],
+                                                    Lanes<W>::broadcast(n))),
+                    this->get(row, col)
+                    );
+                if (_mm256_testz_si256(f, f))
+                    continue;
+                for (int c = 0; c < n; c++)
+                    this->set(row, c, _mm256_xor_si256(
+                                  this->get(row, c),
+                                  W::mul(f, prow[c])
+                                  ));
+            }
+        }
+
+        /* w[pivot column of row] is the element of the row
+         * at the free column */
+        std::vector<long4_t> w1(n);
+        std::vector<long4_t> w2(n);
+        for (int c = 0; c < n; c++)
+        {
+            const long4_t bc = Lanes<W>::broadcast(c);
+            w1[c] = _mm256_and_si256(one, Lanes<W>::equal(c1, bc));
+            w2[c] = _mm256_and_si256(one, Lanes<W>::equal(c2, bc));
+        }
+        for (int row = 0; row < n; row++)
+        {
+            const long4_t x1 = this->select_col(row, c1);
+            const long4_t x2 = this->select_col(row, c2);
+            for (int c = 0; c < n; c++)
+            {
+                const long4_t at = Lanes<W>::equal(pivcol[row],
+                                                   Lanes<W>::broadcast(c));
+                w1[c] = _mm256_or_si256(w1[c], _mm256_and_si256(x1, at));
+                w2[c] = _mm256_or_si256(w2[c], _mm256_and_si256(x2, at));
+            }
+        }
+
+        /* prefix sums as in FMatrix::pdet_low_sum */
+        std::vector<long4_t> S1(n);
+        std::vector<long4_t> S2(n);
+        long4_t s1 = _mm256_setzero_si256();
+        long4_t s2 = _mm256_setzero_si256();
+        for (int j = 0; j < n; j++)
+        {
+            const int i = n - 1 - j;
+            s1 = _mm256_xor_si256(s1, W::mul(this->v[i], w1[i]));
+            s2 = _mm256_xor_si256(s2, W::mul(this->v[i], w2[i]));
+            S1[j] = s1;
+            S2[j] = s2;
+        }
+
+        long4_t sum = _mm256_setzero_si256();
+        for (int i = 0; i < n; i++)
+            sum = _mm256_xor_si256(sum, W::mul(
+                                       this->u[i],
+                                       _mm256_xor_si256(
+                                           W::mul(w1[i], S2[n - 1 - i]),
+                                           W::mul(w2[i], S1[n - 1 - i]))
+                                       ));
+
+        sum = _mm256_andnot_si256(dependent, W::mul(lambda, sum));
+        Lanes<W>::unpack(sum, elems);
+        for (int i = 0; i < VECTOR_N; i++)
+            sums[i] = GF_element<F>(elems[i]);
+    }
+
+    static constexpr int lanes() { return VECTOR_N; }
+};
+
+#endif
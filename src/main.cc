@@ -3,8 +3,6 @@
 #include <vector>
 #include <cmath>
 #include <getopt.h>
-#include <fstream>
-#include <sstream>
 #include <omp.h>
 #include <cstring>
 
@@ -14,53 +12,80 @@
 #include "util.hh"
 #include "fmatrix.hh"
 #include "solver.hh"
+#include "parser.hh"
+#include "batch.hh"
 
 using namespace std;
 
-util::rand64bit global::randgen;
+thread_local util::rand64bit global::randgen;
 GF2_n *global::F;
 GR4_n *global::E;
 bool global::output = true;
 
-bool parse_file(const string &fname, vector<vector<int>> &graph)
+/* solves the graph or the batch over the field F, the fields are set
+ * in main */
+template <typename F>
+static int solve(CSR adj,
+                 const vector<string> &sources,
+                 const Run_options &run,
+                 const bool batch,
+                 const bool duration)
 {
-    ifstream file(fname);
-
-    if (!file.is_open())
+    if (batch)
     {
-        cout << "unable to open file: " << fname << endl;
-        return false;
+        /* the results are the output */
+        global::output = false;
+        const double start = omp_get_wtime();
+        const long graphs = util::solve_batch<F>(sources, run);
+        const double end = omp_get_wtime();
+        if (graphs == -1)
+            return -1;
+
+        if (duration)
+            cout << "computed " << graphs << " graphs in "
+                 << end - start << " seconds." << endl;
+        return 0;
     }
 
-    string line;
-    int u = 0;
-    while (getline(file, line))
+    if (run.direct)
+        adj = util::direct_undirected(adj);
+
+    Graph<F> G(move(adj));
+    Solver<F> s;
+
+    const double start = omp_get_wtime();
+    const int k = util::solve(s, G, run);
+    const double end = omp_get_wtime();
+
+    if (k == FIELD_TOO_SMALL)
     {
-        /* comment */
-        if (line[0] == '#')
-            continue;
-        istringstream iss(line);
-        int v;
-        vector<int> vec;
-        while (iss >> v)
-            vec.push_back(v);
-        graph.push_back(vec);
-        u++;
+        cout << "a component of the graph has too many vertices for "
+             << "the field, please a larger n" << endl;
+        return -1;
+    }
+    cout << k << endl;
+
+    if (duration) {
+        const double delta = end - start;
+        cout << "computed graph of " << G.get_n() << " vertices in ";
+        cout << delta << " seconds." << endl;
     }
-    file.close();
 
-    return true;
+    return 0;
 }
 
 int main(const int argc, char **argv)
 {
     if (argc == 1 || (argc == 2 && strcmp(argv[1], "--help") == 0))
     {
-        cout << "Usage: digraph -f <file> [-b] [-q] [-t] [-u] [-n <field exponent>] [-s <seed>] [-p <threads>]" << endl;
+        cout << "Usage: digraph -f <file> [-b] [-e] [-q] [-t] [-u] [-n <field exponent>] [-s <seed>] [-p <threads>]" << endl;
+        cout << "       digraph -a [-b] [-e] [-t] [-u] [-n <field exponent>] [-s <seed>] [-p <threads>] <source>..." << endl;
         cout << endl;
         cout << "Options:" << endl;
-        cout << " -f\t path to a graph file (custom syntax explained in readme.md)" << endl;
+        cout << " -f\t path to a graph file, - for stdin. the syntax of readme.md, digraph6, graph6, DIMACS or a binary from digraph-convert" << endl;
+        cout << " -a\t batch mode: solve each graph of the sources (files, directories or - for stdin, digraph6 and graph6 with a graph per line) and output \"<name> <result>\" lines in input order" << endl;
         cout << " -b\t use brute force solver (exponential complexity)" << endl;
+        cout << " -e\t only decide if the graph has an even cycle (outputs 1 or 0)" << endl;
         cout << " -q\t do not output progress of computation" << endl;
         cout << " -t\t output computation time" << endl;
         cout << " -u\t direct the input graph (random process)" << endl;
@@ -73,34 +98,38 @@ int main(const int argc, char **argv)
     }
 
     int opt;
-    vector<vector<int>> graph;
+    string fname;
+    Run_options run;
 
-    bool brute = false;
+    bool batch = false;
     bool duration = false;
-    bool direct = false;
     bool file_given = false;
     uint64_t seed = time(nullptr);
     int n = 16;
     int p = 1;
 
-    while ((opt = getopt(argc, argv, "utqbf:s:n:p:")) != -1)
+    while ((opt = getopt(argc, argv, "aeutqbf:s:n:p:")) != -1)
     {
         switch (opt)
         {
         case 'f':
             file_given = true;
-            /* error during parsing */
-            if (!parse_file(optarg, graph))
-                return -1;
+            fname = optarg;
             break;
         case 's':
             seed = stoi(optarg);
             break;
+        case 'a':
+            batch = true;
+            break;
         case 'u':
-            direct = true;
+            run.direct = true;
             break;
         case 'b':
-            brute = true;
+            run.brute = true;
+            break;
+        case 'e':
+            run.decide = true;
             break;
         case 't':
             duration = true;
@@ -120,11 +149,22 @@ int main(const int argc, char **argv)
         }
     }
 
-    if (!file_given)
+    vector<string> sources;
+    if (file_given)
+        sources.push_back(fname);
+    for (int i = optind; batch && i < argc; i++)
+        sources.push_back(argv[i]);
+
+    if (!batch && !file_given)
     {
         cout << "-f is mandatory!" << endl;
         return -1;
     }
+    if (batch && sources.empty())
+    {
+        cout << "-a needs at least one source!" << endl;
+        return -1;
+    }
 
     if (n > 32 || n < 3)
     {
@@ -132,24 +172,32 @@ int main(const int argc, char **argv)
         return -1;
     }
 
-    cout << "seed: " << seed << endl;
-    global::randgen.init(seed);
+    /* the parser uses the threads too */
     omp_set_num_threads(p);
 
+    CSR adj;
+    /* error during parsing */
+    if (!batch && !util::parse_file(fname, adj))
+        return -1;
+
+    cout << "seed: " << seed << endl;
+    global::randgen.init_all(seed);
+    run.seed = seed;
+
     uint64_t mod;
     switch (n)
     {
     case 16:
         /* x^16 + x^5 + x^3 + x^2 +  1 */
-        mod = 0x1002D;
-        global::F = new GF2_16(16, mod);
-        global::E = new GR4_16(16, mod);
+        mod = GF2_16::get_mod();
+        global::F = new GF2_n(16, mod);
+        global::E = new GR4_n(16, mod);
         break;
     case 32:
         /* x^32 + x^7 + x^3 + x^2 + 1 */
-        mod = 0x10000008D;
-        global::F = new GF2_32(32, mod);
-        global::E = new GR4_32(32, mod);
+        mod = GF2_32::get_mod();
+        global::F = new GF2_n(32, mod);
+        global::E = new GR4_n(32, mod);
         break;
     default:
         mod = util::irred_poly(n);
@@ -158,25 +206,13 @@ int main(const int argc, char **argv)
         break;
     }
 
-    if (direct)
-        util::direct_undirected(graph);
-
-    Graph G(graph);
-    Solver s;
-
-    const double start = omp_get_wtime();
-    const int k = (brute)
-        ? s.shortest_even_cycle_brute(G)
-        : s.shortest_even_cycle(G);
-    const double end = omp_get_wtime();
-
-    cout << k << endl;
-
-    if (duration) {
-        const double delta = end - start;
-        cout << "computed graph of " << G.get_n() << " vertices in ";
-        cout << delta << " seconds." << endl;
+    switch (n)
+    {
+    case 16:
+        return solve<GF2_16>(move(adj), sources, run, batch, duration);
+    case 32:
+        return solve<GF2_32>(move(adj), sources, run, batch, duration);
+    default:
+        return solve<GF2_generic>(move(adj), sources, run, batch, duration);
     }
-
-    return 0;
 }
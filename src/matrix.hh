@@ -4,6 +4,30 @@
 
 #include <valarray>
 
+/* the row operations below a pivot are split to tasks of
+ * ROW_GRAIN rows when there are at least PARALLEL_ROWS rows */
+constexpr int PARALLEL_ROWS = 128;
+constexpr int ROW_GRAIN = 16;
+
+namespace util
+{
+    /* f(i) for each i in [lo, hi), independent of each other */
+    template <typename F>
+    inline void for_rows(const int lo, const int hi, const F &f)
+    {
+        if (hi - lo < PARALLEL_ROWS)
+        {
+            for (int i = lo; i < hi; i++)
+                f(i);
+            return;
+        }
+
+        #pragma omp taskloop grainsize(ROW_GRAIN) shared(f)
+        for (int i = lo; i < hi; i++)
+            f(i);
+    }
+}
+
 template <typename T>
 class Matrix
 {
@@ -4,6 +4,7 @@
 
 #include <valarray>
 #include <vector>
+#include <utility>
 #include <immintrin.h>
 
 #include "gf.hh"
@@ -12,20 +13,301 @@
 
 typedef long long int long4_t __attribute__ ((vector_size (32)));
 
-constexpr int VECTOR_N = 8;
+/* multiplication and squaring of packed elements. VECTOR_N is the amount
+ * of elements in one vector, either 8 in 32-bit lanes
+ * or 4 in 64-bit lanes. packed_dets uses det_fraction_free up to
+ * FRACTION_FREE_MAX rows, past that the extra multiplications cost more
+ * than the inversions. measured with fmatrix-perf, slower multiplications
+ * lose sooner */
+struct Wide_16
+{
+    static constexpr int VECTOR_N = 8;
+    static constexpr int FRACTION_FREE_MAX = 24;
+    static inline long4_t mul(const long4_t &a, const long4_t &b)
+    {
+        return global::F->wide_mul(a, b);
+    }
+    static inline long4_t sqr(const long4_t &a)
+    {
+        return global::F->wide_sqr(a);
+    }
+};
+
+struct Wide_32
+{
+    static constexpr int VECTOR_N = 4;
+    static constexpr int FRACTION_FREE_MAX = 24;
+    static inline long4_t mul(const long4_t &a, const long4_t &b)
+    {
+        return global::F->wide_mul_32(a, b);
+    }
+    static inline long4_t sqr(const long4_t &a)
+    {
+        return global::F->wide_sqr_32(a);
+    }
+};
+
+/* any field with n <= 16 */
+struct Wide_n
+{
+    static constexpr int VECTOR_N = 8;
+    static constexpr int FRACTION_FREE_MAX = 16;
+    static inline long4_t mul(const long4_t &a, const long4_t &b)
+    {
+        return global::F->wide_mul_n(a, b);
+    }
+    static inline long4_t sqr(const long4_t &a)
+    {
+        return global::F->wide_sqr_n(a);
+    }
+};
+
+/* any field with n <= 32 */
+struct Wide_n_64
+{
+    static constexpr int VECTOR_N = 4;
+    static constexpr int FRACTION_FREE_MAX = 12;
+    static inline long4_t mul(const long4_t &a, const long4_t &b)
+    {
+        return global::F->wide_mul_n_64(a, b);
+    }
+    static inline long4_t sqr(const long4_t &a)
+    {
+        return global::F->wide_sqr_n_64(a);
+    }
+};
 
+/* moving elements between the lanes and uint64_t arrays */
+template <typename W>
+struct Lanes
+{
+    static constexpr int VECTOR_N = W::VECTOR_N;
+    /* 32-bit words per element */
+    static constexpr int WORDS = 8 / VECTOR_N;
+
+    /* element i of e goes to lane i */
+    static long4_t pack(const uint64_t *e)
+    {
+        if constexpr (VECTOR_N == 8)
+            return _mm256_set_epi32(e[7], e[6], e[5], e[4],
+                                    e[3], e[2], e[1], e[0]);
+        else
+            return _mm256_set_epi64x(e[3], e[2], e[1], e[0]);
+    }
+
+    static void unpack(const long4_t &v, uint64_t *e)
+    {
+        if constexpr (VECTOR_N == 8)
+        {
+            uint32_t words[8];
+            _mm256_storeu_si256((__m256i *) words, v);
+            for (int i = 0; i < VECTOR_N; i++)
+                e[i] = words[i];
+        }
+        else
+        {
+            _mm256_storeu_si256((__m256i *) e, v);
+        }
+    }
+
+    static long4_t broadcast(const uint64_t e)
+    {
+        if constexpr (VECTOR_N == 8)
+            return _mm256_set1_epi32(e);
+        else
+            return _mm256_set1_epi64x(e);
+    }
+
+    /* ones in the lanes where a and b are equal */
+    static long4_t equal(const long4_t &a, const long4_t &b)
+    {
+        if constexpr (VECTOR_N == 8)
+            return _mm256_cmpeq_epi32(a, b);
+        else
+            return _mm256_cmpeq_epi64(a, b);
+    }
+
+    /* ones in the lanes that are zero */
+    static long4_t zero_lanes(const long4_t &v)
+    {
+        return equal(v, _mm256_setzero_si256());
+    }
+
+    /* ones at lane idx */
+    static long4_t lane_mask(const int idx)
+    {
+        uint64_t e[VECTOR_N] = { };
+        e[idx] = (VECTOR_N == 8) ? 0xFFFFFFFFull : 0xFFFFFFFFFFFFFFFFull;
+        return pack(e);
+    }
+
+    /* lane i of v to lane i + s, s may be negative. the lanes left
+     * empty are taken from fill */
+    static long4_t lane_shift(const long4_t &v,
+                              const int s,
+                              const long4_t &fill)
+    {
+        uint64_t e[8];
+        uint64_t m[VECTOR_N];
+        for (int i = 0; i < 8; i++)
+        {
+            const int lane = i / WORDS - s;
+            e[i] = (lane >= 0 && lane < VECTOR_N) ? WORDS*lane + i % WORDS : 0;
+        }
+        for (int i = 0; i < VECTOR_N; i++)
+            m[i] = (i - s >= 0 && i - s < VECTOR_N) ? ~0ull : 0x0;
+        const long4_t perm = _mm256_set_epi32(e[7], e[6], e[5], e[4],
+                                              e[3], e[2], e[1], e[0]);
+        return _mm256_blendv_epi8(fill,
+                                  _mm256_permutevar8x32_epi32(v, perm),
+                                  pack(m));
+    }
+
+    /* inverses of the lanes with one inversion for all of them
+     * (montgomery's trick). the products of the lanes before and after
+     * each lane are scans of W::mul on the vector, only the inversion
+     * of the product of all lanes is scalar. zero lanes stay zero */
+    static long4_t batch_inverse(const long4_t &v)
+    {
+        const long4_t one = broadcast(0x1);
+        const long4_t zero = zero_lanes(v);
+        const long4_t a = _mm256_blendv_epi8(v, one, zero);
+
+        /* products of the lanes up to and from each lane */
+        long4_t prefix = a;
+        long4_t suffix = a;
+        for (int s = 1; s < VECTOR_N; s *= 2)
+        {
+            prefix = W::mul(prefix, lane_shift(prefix, s, one));
+            suffix = W::mul(suffix, lane_shift(suffix, -s, one));
+        }
+
+        uint64_t elems[VECTOR_N];
+        unpack(prefix, elems);
+        const uint64_t inv = global::F->ext_euclid(elems[VECTOR_N - 1]);
+
+        /* the other lanes times the inverse of all of them */
+        const long4_t others = W::mul(lane_shift(prefix, 1, one),
+                                      lane_shift(suffix, -1, one));
+        return _mm256_andnot_si256(zero, W::mul(others, broadcast(inv)));
+    }
+
+    /* inverses of the lanes with GF2_n::itoh_tsujii on the vector,
+     * without leaving it. zero lanes stay zero */
+    static long4_t itoh_tsujii(const long4_t &a)
+    {
+        const int m = global::F->get_n() - 1;
+        long4_t b = a;
+        int k = 1;
+        for (int bit = 62 - __builtin_clzll(m); bit >= 0; bit--)
+        {
+            long4_t t = b;
+            for (int i = 0; i < k; i++)
+                t = W::sqr(t);
+            b = W::mul(t, b);
+            k *= 2;
+
+            if ((m >> bit) & 1)
+            {
+                b = W::mul(W::sqr(b), a);
+                k++;
+            }
+        }
+        return W::sqr(b);
+    }
+
+    /* itoh_tsujii with 8 lanes of at most 16 bits, batch_inverse
+     * with 4 lanes where the fields have more squarings */
+    static long4_t inv(const long4_t &a)
+    {
+        if constexpr (VECTOR_N == 8)
+            return itoh_tsujii(a);
+        else
+            return batch_inverse(a);
+    }
+
+    /* permutation that copies lane idx to all lanes */
+    static long4_t lane_broadcast(const int idx)
+    {
+        uint64_t e[8];
+        for (int i = 0; i < 8; i++)
+            e[i] = WORDS*idx + i % WORDS;
+        return _mm256_set_epi32(e[7], e[6], e[5], e[4],
+                                e[3], e[2], e[1], e[0]);
+    }
+};
+
+/* determinant of the rows x rows matrix at a, each row in stride vectors
+ * of VECTOR_N elements. the rows below the pivot are multiplied with the
+ * pivot instead of dividing the pivot row, so det = prod / scale with the
+ * product of the pivots and of the row multipliers. one inversion at the
+ * end instead of one for each column. overwrites a */
+template <typename F, typename W>
+inline GF_element<F> fraction_free_det(long4_t *a,
+                                       const int rows,
+                                       const int stride)
+{
+    constexpr int VECTOR_N = W::VECTOR_N;
+    const auto row = [&](const int r) { return a + r * stride; };
+
+    long4_t prod = Lanes<W>::broadcast(0x1);
+    long4_t scale = Lanes<W>::broadcast(0x1);
+    for (int col = 0; col < rows; col++)
+    {
+        const int v = col / VECTOR_N;
+        const int idx = col % VECTOR_N;
+        const long4_t mask = Lanes<W>::lane_mask(idx);
+
+        int piv = col;
+        while (piv < rows && _mm256_testz_si256(mask, row(piv)[v]))
+            piv++;
+        if (piv == rows)
+            return util::GF_zero<F>();
+        if (piv != col)
+            for (int w = v; w < stride; w++)
+                std::swap(row(piv)[w], row(col)[w]);
+
+        const long4_t perm = Lanes<W>::lane_broadcast(idx);
+        const long4_t pivot = _mm256_permutevar8x32_epi32(row(col)[v], perm);
+        prod = W::mul(prod, pivot);
+
+        for (int r = col + 1; r < rows; r++)
+        {
+            const long4_t f = _mm256_permutevar8x32_epi32(row(r)[v], perm);
+            /* already zero, the padding mostly */
+            if (_mm256_testz_si256(f, f))
+                continue;
+            scale = W::mul(scale, pivot);
+            for (int w = v; w < stride; w++)
+                row(r)[w] = _mm256_xor_si256(W::mul(row(r)[w], pivot),
+                                             W::mul(row(col)[w], f));
+        }
+    }
+
+    /* every lane has the same values */
+    uint64_t elems[VECTOR_N];
+    Lanes<W>::unpack(prod, elems);
+    const GF_element<F> p(elems[0]);
+    Lanes<W>::unpack(scale, elems);
+    return p / GF_element<F>(elems[0]);
+}
+
+/* F is the field of the elements and W its packed multiplication */
+template <typename F, typename W>
 class Packed_FMatrix
 {
 private:
+    static constexpr int VECTOR_N = W::VECTOR_N;
+
+    int n;
     int rows;
     int cols;
-    // original matrix n moduloe VECTOR_N
-    int nmod;
     std::vector<long4_t> m;
-    std::vector<long4_t> coeffs;
     /* vectorized copy of the initial matrix. read from here after each
      * determinant computation. */
     std::vector<long4_t> base;
+    /* gamma powers for mul_gamma */
+    std::vector<uint64_t> powers;
 
     const long4_t &get(const int row, const int col) const
     {
@@ -47,67 +329,12 @@ private:
         this->base[row*this->cols + col] = v;
     }
 
-
-    template <int index>
-    void coeff_loop()
-    {
-        /* cyclic permutation to the right.
-         * maybe could use bit ops? (did not work past 128 bit lanes?) */
-        const long4_t cycle_idx = _mm256_set_epi32(
-            0b000,
-            0b111,
-            0b110,
-            0b101,
-            0b100,
-            0b011,
-            0b010,
-            0b001
-        );
-
-        long4_t idx = _mm256_set_epi32(
-            0b111,
-            0b110,
-            0b101,
-            0b100,
-            0b011,
-            0b010,
-            0b001,
-            0b000
-        );
-
-        /* compiler should optimize this */
-        for (int i = 0; i < index; i++)
-            idx = _mm256_permutevar8x32_epi32(idx, cycle_idx);
-
-        for (int col = 0; col < this->cols - 1; col++)
-            this->coeffs[col] = _mm256_blend_epi32(
-                _mm256_permutevar8x32_epi32(coeffs[col + 0], idx),
-                _mm256_permutevar8x32_epi32(coeffs[col + 1], idx),
-                0xFF >> index
-            );
-
-        this->coeffs[this->cols - 1] = _mm256_permutevar8x32_epi32(
-            this->coeffs[this->cols - 1],
-            idx
-        );
-    }
-
     /* returns true if zero det */
-    template <int index>
-    bool det_loop(const int col, uint64_t &det)
+    bool det_loop(const int col, const int idx, uint64_t &det)
     {
-        const int r0 = VECTOR_N*col + index;
+        const int r0 = VECTOR_N*col + idx;
         int piv_idx = -1;
-        /* optimize */
-        long4_t cmpmsk = _mm256_set_epi64x(
-            0xFFFFull << 32,
-            0,
-            0,
-            0
-        );
-        if (index >= 4)
-            cmpmsk = _mm256_permute4x64_epi64(cmpmsk, 0x0C);
-        cmpmsk = _mm256_srli_si256(cmpmsk, 4*(index%4));
+        const long4_t cmpmsk = Lanes<W>::lane_mask(idx);
         for (int row = r0; row < this->rows; row++)
         {
             const char ZF = _mm256_testz_si256(
@@ -128,28 +355,24 @@ private:
         if (piv_idx != r0)
             this->swap_rows(piv_idx, r0, col);
 
-        constexpr char mask = VECTOR_N - 1 - index;
-        /* rows got swapped */
-        uint64_t pivot =
-            _mm256_extract_epi32(this->get(r0, col), mask);
+        uint64_t elems[VECTOR_N];
+        Lanes<W>::unpack(this->get(r0, col), elems);
+        uint64_t pivot = elems[idx];
         /* vectorize? */
-        det = global::F->rem(
-            global::F->clmul(det, pivot)
-        );
-        pivot = global::F->ext_euclid(pivot);
-        this->mul_row(r0, col, _mm256_set1_epi32(pivot));
+        det = F::rem(F::clmul(det, pivot));
+        pivot = F::ext_euclid(pivot);
+        this->mul_row(r0, col, Lanes<W>::broadcast(pivot));
 
-        /* vectorize end? */
-        const long4_t idx = _mm256_set1_epi32(mask);
+        const long4_t perm = Lanes<W>::lane_broadcast(idx);
 
-        for (int row = r0 + 1; row < this->rows; row++)
+        util::for_rows(r0 + 1, this->rows, [&](const int row)
         {
             const long4_t val = _mm256_permutevar8x32_epi32(
                 this->get(row, col),
-                idx
+                perm
             );
             this->row_op(r0, row, col, val);
-        }
+        });
 
         return false;
     }
@@ -166,34 +389,32 @@ private:
     }
 
     /* starting from column idx */
-    inline void mul_row(const int row, const int idx, const long4_t &pack)
+    inline void mul_row(const int row, const int idx, const long4_t &v)
     {
         for (int col = idx; col < this->cols; col++)
-            this->set(row, col,
-                      global::F->wide_mul(this->get(row, col), pack)
-                );
+            this->set(row, col, W::mul(this->get(row, col), v));
     }
 
     /* subtract v times r1 from r2, starting from column idx */
     inline void row_op(const int r1,
                        const int r2,
                        const int idx,
-                       const long4_t &pack
+                       const long4_t &v
     )
     {
         for (int col = idx; col < this->cols; col++)
             this->set(r2, col,
                       _mm256_xor_si256(
                           this->get(r2, col),
-                          global::F->wide_mul(this->get(r1, col), pack)
+                          W::mul(this->get(r1, col), v)
                       )
             );
     }
 
 public:
-    Packed_FMatrix(const int n, const FMatrix &matrix)
+    Packed_FMatrix(const int n, const FMatrix<F> &matrix)
     {
-        this->nmod = n % VECTOR_N;
+        this->n = n;
         this->rows = n;
         if (this->rows % VECTOR_N)
             this->rows += VECTOR_N - (n % VECTOR_N);
@@ -201,95 +422,25 @@ public:
 
         this->m.resize(this->rows * this->cols);
         this->base.resize(this->rows * this->cols);
-        this->coeffs.resize(this->cols);
+        this->powers.resize(this->rows);
 
-        for (int r = 0; r < matrix.get_n(); r++)
+        uint64_t elems[VECTOR_N];
+        for (int r = 0; r < this->rows; r++)
         {
-            for (int c = 0; c < matrix.get_n() / VECTOR_N; c++)
-                this->set_base(r, c,
-                          _mm256_set_epi32(
-                              matrix(r, VECTOR_N*c + 0).get_repr(),
-                              matrix(r, VECTOR_N*c + 1).get_repr(),
-                              matrix(r, VECTOR_N*c + 2).get_repr(),
-                              matrix(r, VECTOR_N*c + 3).get_repr(),
-                              matrix(r, VECTOR_N*c + 4).get_repr(),
-                              matrix(r, VECTOR_N*c + 5).get_repr(),
-                              matrix(r, VECTOR_N*c + 6).get_repr(),
-                              matrix(r, VECTOR_N*c + 7).get_repr()
-                              )
-                    );
-            if (this->nmod)
+            for (int c = 0; c < this->cols; c++)
             {
-                const int c = this->cols - 1;
-                uint64_t elems[VECTOR_N];
                 for (int i = 0; i < VECTOR_N; i++)
-                    elems[i] = 0;
-                for (int i = 0; i < this->nmod; i++)
-                    elems[i] = matrix(r, VECTOR_N*c + i).get_repr();
-
-                this->set_base(r, c, _mm256_set_epi32(
-                              elems[0], elems[1],
-                              elems[2], elems[3],
-                              elems[4], elems[5],
-                              elems[6], elems[7]
-                              )
-                    );
-            }
-        }
-        for (int r = matrix.get_n(); r < this->rows; r++)
-        {
-            for (int c = 0; c < this->cols - 1; c++)
-                this->set_base(r, c, _mm256_setzero_si256());
-
-            /* lazy.... */
-            switch (r % VECTOR_N)
-            {
-            case 1:
-                this->set_base(r, this->cols - 1, _mm256_set_epi64x(
-                              1, 0, 0, 0
-                              )
-                    );
-                break;
-            case 2:
-                this->set_base(r, this->cols - 1, _mm256_set_epi64x(
-                              0, 1ull << 32, 0, 0
-                              )
-                    );
-                break;
-            case 3:
-                this->set_base(r, this->cols - 1, _mm256_set_epi64x(
-                              0, 1, 0, 0
-                              )
-                    );
-                break;
-            case 4:
-                this->set_base(r, this->cols - 1, _mm256_set_epi64x(
-                              0, 0, 1ull << 32, 0
-                              )
-                    );
-                break;
-            case 5:
-                this->set_base(r, this->cols - 1, _mm256_set_epi64x(
-                              0, 0, 1, 0
-                              )
-                    );
-                break;
-            case 6:
-                this->set_base(r, this->cols - 1, _mm256_set_epi64x(
-                              0, 0, 0, 1ull << 32
-                              )
-                    );
-                break;
-            case 7:
-                this->set_base(r, this->cols - 1, _mm256_set_epi64x(
-                              0, 0, 0, 1
-                              )
-                    );
-                break;
+                {
+                    const int col = VECTOR_N*c + i;
+                    if (r < n && col < n)
+                        elems[i] = matrix(r, col).get_repr();
+                    else
+                        /* pad with identity */
+                        elems[i] = (r == col);
+                }
+                this->set_base(r, c, Lanes<W>::pack(elems));
             }
-
         }
-
     }
 
     void init()
@@ -299,157 +450,83 @@ public:
                 this->set(row, col, this->get_base(row, col));
     }
 
-    void mul_gamma(const int r1, const int r2, const GF_element &gamma)
+    void mul_gamma(const int r1, const int r2, const GF_element<F> &gamma)
     {
-        /* here we do r1 first left to right and save the auxiliary gamma vectors.
-         * then we permute the gamma vectors as required (note this->nmod here),
-         * and do r2 left to right */
-        /* do gamma multiplication during initialization?? */
-        long4_t pac_gamma = _mm256_set1_epi32(gamma.get_repr());
+        /* here we do r1 first left to right and save the gamma powers.
+         * then r2 is done with the powers in reverse order */
+        long4_t pac_gamma = Lanes<W>::broadcast(gamma.get_repr());
         // pac_gamma = [gamma^VECTOR_N]
-        pac_gamma = global::F->wide_mul(pac_gamma, pac_gamma);
-        pac_gamma = global::F->wide_mul(pac_gamma, pac_gamma);
-        pac_gamma = global::F->wide_mul(pac_gamma, pac_gamma);
+        for (int i = 1; i < VECTOR_N; i <<= 1)
+            pac_gamma = W::sqr(pac_gamma);
 
         uint64_t elems[VECTOR_N];
         uint64_t g = 1ull;
         for (int i = 0; i < VECTOR_N; i++)
         {
             elems[i] = g;
-            g = global::F->rem(global::F->clmul(g, gamma.get_repr()));
+            g = F::rem(F::clmul(g, gamma.get_repr()));
         }
-        long4_t prod = _mm256_set_epi32(
-            elems[0], elems[1],
-            elems[2], elems[3],
-            elems[4], elems[5],
-            elems[6], elems[7]
-        );
-
-        /* reverse order permutation of 32 bits */
-        const long4_t idx = _mm256_set_epi32(
-            0b000,
-            0b001,
-            0b010,
-            0b011,
-            0b100,
-            0b101,
-            0b110,
-            0b111
-        );
-        /* first do left to right r1 */
+        long4_t prod = Lanes<W>::pack(elems);
+
         for (int col = 0; col < this->cols; col++)
         {
-            /* already save them in reverse order here and permute,
-             * values in reverse order, too*/
-            this->coeffs[this->cols - 1 - col] = _mm256_permutevar8x32_epi32(
-                prod,
-                idx
-            );
-            const long4_t elem = global::F->wide_mul(this->get(r1, col), prod);
-            this->set(r1, col, elem);
-
-            prod = global::F->wide_mul(prod, pac_gamma);
+            Lanes<W>::unpack(prod, &this->powers[VECTOR_N*col]);
+            this->set(r1, col, W::mul(this->get(r1, col), prod));
+            prod = W::mul(prod, pac_gamma);
         }
 
-        /* handle special permutations required in case not divisible by 4 */
-        if (this->nmod)
+        for (int col = 0; col < this->cols; col++)
         {
-            switch (this->nmod)
+            for (int i = 0; i < VECTOR_N; i++)
             {
-            case 1:
-                coeff_loop<1>();
-                break;
-            case 2:
-                coeff_loop<2>();
-                break;
-            case 3:
-                coeff_loop<3>();
-                break;
-            case 4:
-                coeff_loop<4>();
-                break;
-            case 5:
-                coeff_loop<5>();
-                break;
-            case 6:
-                coeff_loop<6>();
-                break;
-            case 7:
-                coeff_loop<7>();
-                break;
+                /* padded columns are zero at r2 */
+                const int exp = this->n - 1 - VECTOR_N*col - i;
+                elems[i] = (exp >= 0) ? this->powers[exp] : 0x0;
             }
-        }
-
-        /* and do r2 left to right */
-        for (int col = 0; col < this->cols; col++)
-        {
-            this->set(r2, col,
-                      global::F->wide_mul(
-                          this->get(r2, col),
-                          this->coeffs[col]
-                      )
-                );
+            this->set(r2, col, W::mul(this->get(r2, col),
+                                      Lanes<W>::pack(elems)));
         }
     }
 
-    GF_element det()
+    GF_element<F> det()
     {
         uint64_t det = 0x1;
         for (int col = 0; col < this->cols; col++)
         {
-            /* each "column" is a vector that has 8 real columns.
+            /* each "column" is a vector that has VECTOR_N real columns.
              * each call returns true if the determinant is zero */
-            if (det_loop<0>(col, det) || det_loop<1>(col, det)
-                || det_loop<2>(col, det) || det_loop<3>(col, det)
-                || det_loop<4>(col, det) || det_loop<5>(col, det)
-                || det_loop<6>(col, det) || det_loop<7>(col, det))
-                break;
+            for (int idx = 0; idx < VECTOR_N; idx++)
+                if (det_loop(col, idx, det))
+                    return GF_element<F>(det);
         }
-        return GF_element(det);
+        return GF_element<F>(det);
+    }
+
+    /* det without an inversion for each pivot, one division at the end.
+     * twice the multiplications of det in the row operations */
+    GF_element<F> det_fraction_free()
+    {
+        return fraction_free_det<F, W>(this->m.data(), this->rows, this->cols);
     }
 
     /* only used for testing */
-    FMatrix unpack() const
+    FMatrix<F> unpack() const
     {
-        std::valarray<GF_element> unpacked(this->rows * this->rows);
+        FMatrix<F> unpacked(this->n);
+        uint64_t elems[VECTOR_N];
 
-        for (int row = 0; row < this->rows; row++)
+        for (int row = 0; row < this->n; row++)
         {
             for (int col = 0; col < this->cols; col++)
             {
-                for (int e = 0; e < VECTOR_N; e++)
-                {
-                    uint64_t rep;
-                    switch (e/2)
-                    {
-                    case 0:
-                        rep = _mm256_extract_epi64(this->get(row, col), 3);
-                        break;
-                    case 1:
-                        rep = _mm256_extract_epi64(this->get(row, col), 2);
-                        break;
-                    case 2:
-                        rep = _mm256_extract_epi64(this->get(row, col), 1);
-                        break;
-                    case 3:
-                        rep = _mm256_extract_epi64(this->get(row, col), 0);
-                        break;
-                    }
-                    if (e%2)
-                        rep &= 0xFFFF;
-                    else
-                        rep >>= 32*(1 - e%2);
-                    unpacked[row*this->rows + VECTOR_N*col + e] =
-                        GF_element(rep);
-                }
+                Lanes<W>::unpack(this->get(row, col), elems);
+                for (int i = 0; i < VECTOR_N && VECTOR_N*col + i < this->n; i++)
+                    unpacked.set(row, VECTOR_N*col + i,
+                                 GF_element<F>(elems[i]));
             }
         }
 
-        const uint64_t r = this->rows;
-        uint64_t n = this->rows;
-        if (this->nmod)
-            n -= VECTOR_N - this->nmod;
-        return FMatrix(n, unpacked[std::gslice(0, {n,n}, {r,1})]);
+        return unpacked;
     }
 };
 
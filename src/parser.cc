@@ -0,0 +1,914 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+#include "parser.hh"
+#include "csr.hh"
+
+using namespace std;
+
+/* smaller inputs are parsed by one thread */
+static constexpr long PARALLEL_BYTES = 1 << 20;
+/* the nauty and DIMACS headers give the vertex count before any arcs.
+ * larger counts are rejected instead of allocated */
+static constexpr long HEADER_VERTICES = 1 << 20;
+
+/* lines of the input starting from a line start */
+struct Chunk
+{
+    const char *begin;
+    const char *end;
+    /* the vertices of the chunk, offsets start from zero */
+    CSR part;
+    /* lines including comments, for the error messages */
+    long lines = 0;
+    /* largest vertex id and its line, validated once n is known */
+    int max_id = -1;
+    long max_line = 0;
+    /* line of the first syntax error, -1 without errors */
+    long error_line = -1;
+    string error;
+};
+
+static inline bool is_digit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool is_space(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* the id starting at p, false if it does not fit in an int */
+static inline bool scan_id(const char *&p, const char *end, long &v)
+{
+    v = 0;
+    for (; p < end && is_digit(*p); p++)
+    {
+        v = 10*v + (*p - '0');
+        if (v > INT_MAX)
+            return false;
+    }
+    return true;
+}
+
+/* past the next newline */
+static inline const char *next_line(const char *p, const char *end)
+{
+    const char *nl = (const char *) memchr(p, '\n', end - p);
+    return (nl) ? nl + 1 : end;
+}
+
+/* appends the vertices of the chunk to adj, stops at the first error */
+static void parse_chunk(Chunk &chunk, CSR &adj)
+{
+    const char *p = chunk.begin;
+    const char *const end = chunk.end;
+
+    while (p < end)
+    {
+        chunk.lines++;
+
+        /* comment */
+        if (*p == '#')
+        {
+            p = next_line(p, end);
+            continue;
+        }
+
+        while (p < end && *p != '\n')
+        {
+            if (is_space(*p))
+            {
+                p++;
+                continue;
+            }
+
+            if (!is_digit(*p))
+            {
+                chunk.error_line = chunk.lines;
+                chunk.error = "unexpected character '" + string(1, *p) + "'";
+                return;
+            }
+
+            long v;
+            if (!scan_id(p, end, v))
+            {
+                chunk.error_line = chunk.lines;
+                chunk.error = "vertex id does not fit in an int";
+                return;
+            }
+
+            if (v > chunk.max_id)
+            {
+                chunk.max_id = v;
+                chunk.max_line = chunk.lines;
+            }
+            adj.targets.push_back(v);
+        }
+        adj.offsets.push_back(adj.targets.size());
+
+        /* the newline */
+        p++;
+    }
+}
+
+bool util::parse_graph(const char *begin,
+                       const char *end,
+                       CSR &adj,
+                       string &error,
+                       int chunks)
+{
+    if (chunks <= 0)
+        chunks = (end - begin < PARALLEL_BYTES) ? 1 : omp_get_max_threads();
+
+    /* split at the newlines following even cuts */
+    vector<Chunk> parts(chunks);
+    parts[0].begin = begin;
+    for (int i = 1; i < chunks; i++)
+    {
+        const char *p = max(begin + (end - begin) * i / chunks,
+                            parts[i - 1].begin);
+        if (p > begin && p < end && p[-1] != '\n')
+            p = next_line(p, end);
+        parts[i - 1].end = p;
+        parts[i].begin = p;
+    }
+    parts[chunks - 1].end = end;
+
+    adj = CSR();
+    if (chunks == 1)
+    {
+        parse_chunk(parts[0], adj);
+    }
+    else
+    {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int i = 0; i < chunks; i++)
+            parse_chunk(parts[i], parts[i].part);
+    }
+
+    /* the first error in file order */
+    long line = 0;
+    for (int i = 0; i < chunks; i++)
+    {
+        if (parts[i].error_line != -1)
+        {
+            error = "line " + to_string(line + parts[i].error_line) + ": "
+                + parts[i].error;
+            return false;
+        }
+        line += parts[i].lines;
+    }
+
+    if (chunks > 1)
+    {
+        /* first vertex and arc of each chunk */
+        vector<long> vbase(chunks + 1, 0);
+        vector<long> abase(chunks + 1, 0);
+        for (int i = 0; i < chunks; i++)
+        {
+            vbase[i + 1] = vbase[i] + parts[i].part.get_n();
+            abase[i + 1] = abase[i] + parts[i].part.get_m();
+        }
+
+        if (abase[chunks] > INT_MAX)
+        {
+            error = "too many arcs";
+            return false;
+        }
+
+        adj.offsets.resize(vbase[chunks] + 1);
+        adj.targets.resize(abase[chunks]);
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int i = 0; i < chunks; i++)
+        {
+            const CSR &part = parts[i].part;
+            for (int v = 1; v <= part.get_n(); v++)
+                adj.offsets[vbase[i] + v] = abase[i] + part.offsets[v];
+            copy(part.targets.begin(), part.targets.end(),
+                 adj.targets.begin() + abase[i]);
+        }
+    }
+
+    /* every arc has to end at one of the lines */
+    line = 0;
+    for (int i = 0; i < chunks; i++)
+    {
+        if (parts[i].max_id >= adj.get_n())
+        {
+            error = "line " + to_string(line + parts[i].max_line)
+                + ": vertex id " + to_string(parts[i].max_id)
+                + " out of range, the graph has " + to_string(adj.get_n())
+                + " vertices";
+            return false;
+        }
+        line += parts[i].lines;
+    }
+
+    return true;
+}
+
+bool util::parse_edge_list(const char *begin,
+                           const char *end,
+                           CSR &adj,
+                           string &error)
+{
+    vector<int> tails;
+    vector<int> heads;
+    long max_id = -1;
+    long line = 0;
+    const char *p = begin;
+
+    while (p < end)
+    {
+        line++;
+
+        /* comment */
+        if (*p == '#' || *p == '%')
+        {
+            p = next_line(p, end);
+            continue;
+        }
+
+        long ids[2];
+        int k = 0;
+        while (p < end && *p != '\n')
+        {
+            if (is_space(*p))
+            {
+                p++;
+                continue;
+            }
+
+            if (!is_digit(*p))
+            {
+                error = "line " + to_string(line)
+                    + ": unexpected character '" + string(1, *p) + "'";
+                return false;
+            }
+            if (k == 2)
+            {
+                error = "line " + to_string(line) + ": more than two ids";
+                return false;
+            }
+            if (!scan_id(p, end, ids[k]))
+            {
+                error = "line " + to_string(line)
+                    + ": vertex id does not fit in an int";
+                return false;
+            }
+            max_id = max(max_id, ids[k]);
+            k++;
+        }
+
+        /* empty lines are fine */
+        if (k == 1)
+        {
+            error = "line " + to_string(line) + ": an arc needs two ids";
+            return false;
+        }
+        if (k == 2)
+        {
+            tails.push_back(ids[0]);
+            heads.push_back(ids[1]);
+        }
+
+        /* the newline */
+        p++;
+    }
+
+    if (max_id >= INT_MAX)
+    {
+        error = "too many vertices";
+        return false;
+    }
+
+    /* counting sort by the tail, keeps the order of the arcs */
+    const int n = max_id + 1;
+    adj = CSR();
+    adj.offsets.assign(n + 1, 0);
+    for (const int u : tails)
+        adj.offsets[u + 1]++;
+    for (int u = 0; u < n; u++)
+        adj.offsets[u + 1] += adj.offsets[u];
+
+    vector<int> pos(adj.offsets.begin(), adj.offsets.end() - 1);
+    adj.targets.resize(tails.size());
+    for (unsigned int i = 0; i < tails.size(); i++)
+        adj.targets[pos[tails[i]]++] = heads[i];
+
+    return true;
+}
+
+/* skips the optional header of the nauty formats */
+static void skip_header(const char *&p, const char *end, const char *header)
+{
+    const long len = strlen(header);
+    if (end - p >= len && memcmp(p, header, len) == 0)
+        p += len;
+}
+
+/* the vertex count of the nauty formats. n < 63 in one byte, then
+ * 126 and three bytes, then 126 126 and six bytes. each byte holds
+ * 6 bits offset by 63, big endian */
+static bool nauty_n(const char *&p, const char *end, uint64_t &n)
+{
+    auto sixes = [&](const int k, uint64_t &x)
+    {
+        x = 0;
+        for (int i = 0; i < k; i++, p++)
+        {
+            if (p == end || *p < 63 || *p > 126)
+                return false;
+            x = (x << 6) | (*p - 63);
+        }
+        return true;
+    };
+
+    bool ok = sixes(1, n);
+    if (ok && n == 63)
+    {
+        if (p < end && *p == 126)
+        {
+            p++;
+            ok = sixes(6, n);
+        }
+        else
+        {
+            ok = sixes(3, n);
+        }
+    }
+    return ok && n < HEADER_VERTICES;
+}
+
+/* checks that there are enough bytes for the bits and that they are valid */
+static bool nauty_bits(const char *p,
+                       const char *end,
+                       const uint64_t bits,
+                       string &error)
+{
+    const uint64_t bytes = (bits + 5) / 6;
+    if ((uint64_t) (end - p) < bytes)
+    {
+        error = "truncated graph";
+        return false;
+    }
+    for (uint64_t i = 0; i < bytes; i++)
+    {
+        if (p[i] < 63 || p[i] > 126)
+        {
+            error = "invalid character '" + string(1, p[i]) + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+/* bit k of the bytes at p, starting from the high bit */
+static inline bool nauty_bit(const char *p, const uint64_t k)
+{
+    return ((p[k / 6] - 63) >> (5 - k % 6)) & 1;
+}
+
+bool util::parse_digraph6(const char *begin,
+                          const char *end,
+                          CSR &adj,
+                          string &error)
+{
+    const char *p = begin;
+    skip_header(p, end, ">>digraph6<<");
+
+    if (p == end || *p != '&')
+    {
+        error = "digraph6 has to start with '&'";
+        return false;
+    }
+    p++;
+
+    uint64_t n;
+    if (!nauty_n(p, end, n))
+    {
+        error = "invalid digraph6 vertex count";
+        return false;
+    }
+    if (!nauty_bits(p, end, n * n, error))
+        return false;
+
+    /* the adjacency matrix row by row */
+    adj = CSR();
+    adj.offsets.reserve(n + 1);
+    for (uint64_t u = 0; u < n; u++)
+    {
+        for (uint64_t v = 0; v < n; v++)
+            if (nauty_bit(p, u*n + v))
+                adj.targets.push_back(v);
+        adj.offsets.push_back(adj.targets.size());
+    }
+
+    return true;
+}
+
+bool util::parse_graph6(const char *begin,
+                        const char *end,
+                        CSR &adj,
+                        string &error)
+{
+    const char *p = begin;
+    skip_header(p, end, ">>graph6<<");
+
+    if (p < end && (*p == ':' || *p == ';'))
+    {
+        error = "sparse6 is not supported";
+        return false;
+    }
+
+    uint64_t n;
+    if (!nauty_n(p, end, n))
+    {
+        error = "invalid graph6 vertex count";
+        return false;
+    }
+    if (!nauty_bits(p, end, n * (n - 1) / 2, error))
+        return false;
+
+    /* the upper triangle column by column, each edge both ways */
+    vector<vector<int>> graph(n);
+    uint64_t k = 0;
+    for (uint64_t v = 1; v < n; v++)
+    {
+        for (uint64_t u = 0; u < v; u++, k++)
+        {
+            if (nauty_bit(p, k))
+            {
+                graph[u].push_back(v);
+                graph[v].push_back(u);
+            }
+        }
+    }
+    adj = CSR(graph);
+
+    return true;
+}
+
+bool util::parse_dimacs(const char *begin,
+                        const char *end,
+                        CSR &adj,
+                        string &error)
+{
+    vector<vector<int>> graph;
+    bool problem = false;
+    long line = 0;
+    const char *p = begin;
+
+    while (p < end)
+    {
+        line++;
+        const char *next = next_line(p, end);
+        const string prefix = "line " + to_string(line) + ": ";
+
+        /* the ids after the kind of the line */
+        long ids[2];
+        int k = 0;
+        const char kind = *p;
+        for (p++; p < next && k < 2; )
+        {
+            if (is_space(*p) || *p == '\n')
+            {
+                p++;
+                continue;
+            }
+            if (kind == 'p' && k == 0 && !is_digit(*p))
+            {
+                /* the problem name */
+                while (p < next && !is_space(*p) && *p != '\n')
+                    p++;
+                continue;
+            }
+            if (!is_digit(*p) || !scan_id(p, next, ids[k]))
+                break;
+            k++;
+        }
+
+        switch (kind)
+        {
+        case 'c':
+        case '\n':
+        case '\r':
+            break;
+        case 'p':
+            if (problem || k != 2)
+            {
+                error = prefix + "expected a single \"p <problem> n m\"";
+                return false;
+            }
+            if (ids[0] >= HEADER_VERTICES)
+            {
+                error = prefix + "too many vertices";
+                return false;
+            }
+            problem = true;
+            graph.resize(ids[0]);
+            break;
+        case 'a':
+        case 'e':
+            if (!problem)
+            {
+                error = prefix + "arc before the problem line";
+                return false;
+            }
+            if (k != 2 || ids[0] < 1 || ids[0] > (long) graph.size()
+                || ids[1] < 1 || ids[1] > (long) graph.size())
+            {
+                error = prefix + "expected two ids in 1, .., n";
+                return false;
+            }
+            /* arcs, the edges go both ways */
+            graph[ids[0] - 1].push_back(ids[1] - 1);
+            if (kind == 'e')
+                graph[ids[1] - 1].push_back(ids[0] - 1);
+            break;
+        default:
+            error = prefix + "unknown line '" + string(1, kind) + "'";
+            return false;
+        }
+
+        p = next;
+    }
+
+    if (!problem)
+    {
+        error = "no problem line";
+        return false;
+    }
+    adj = CSR(graph);
+
+    return true;
+}
+
+Graph_format util::detect_format(const char *begin, const char *end)
+{
+    if (end - begin >= (long) sizeof(BINARY_MAGIC)
+        && memcmp(begin, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0)
+        return BINARY;
+
+    if (begin == end)
+        return LINES;
+
+    /* the rest are told apart by the first character */
+    const char c = begin[0];
+    const char next = (end - begin > 1) ? begin[1] : '\n';
+    if (c == '&' || (c == '>' && end - begin > 2 && begin[2] == 'd'))
+        return DIGRAPH6;
+    /* >>graph6<< */
+    if (c == '>')
+        return GRAPH6;
+    /* graph6 has no spaces */
+    if ((c == 'c' || c == 'p') && (is_space(next) || next == '\n'))
+        return DIMACS;
+    if (c >= 63 && c <= 126)
+        return GRAPH6;
+
+    return LINES;
+}
+
+/* fletcher style sums of the 32-bit words */
+static void checksum(const int *data,
+                     const uint64_t len,
+                     uint64_t &s1,
+                     uint64_t &s2)
+{
+    for (uint64_t i = 0; i < len; i++)
+    {
+        s1 += (uint32_t) data[i];
+        s2 += s1;
+    }
+}
+
+static uint64_t checksum(const CSR &adj)
+{
+    uint64_t s1 = 0;
+    uint64_t s2 = 0;
+    checksum(adj.offsets.data(), adj.offsets.size(), s1, s2);
+    checksum(adj.targets.data(), adj.targets.size(), s1, s2);
+    return s1 ^ ((s2 << 32) | (s2 >> 32));
+}
+
+vector<char> util::to_binary(const CSR &adj)
+{
+    Binary_header header;
+    memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.version = BINARY_VERSION;
+    header.flags = 0;
+    header.n = adj.get_n();
+    header.m = adj.get_m();
+    header.checksum = checksum(adj);
+
+    const uint64_t off_bytes = adj.offsets.size() * sizeof(int);
+    const uint64_t tgt_bytes = adj.targets.size() * sizeof(int);
+    vector<char> out(sizeof(header) + off_bytes + tgt_bytes);
+    memcpy(out.data(), &header, sizeof(header));
+    memcpy(out.data() + sizeof(header), adj.offsets.data(), off_bytes);
+    memcpy(out.data() + sizeof(header) + off_bytes,
+           adj.targets.data(), tgt_bytes);
+
+    return out;
+}
+
+bool util::parse_binary(const char *begin,
+                        const char *end,
+                        CSR &adj,
+                        string &error)
+{
+    Binary_header header;
+    const uint64_t size = end - begin;
+    if (size < sizeof(header))
+    {
+        error = "truncated binary header";
+        return false;
+    }
+    memcpy(&header, begin, sizeof(header));
+
+    if (memcmp(header.magic, BINARY_MAGIC, sizeof(header.magic)) != 0)
+    {
+        error = "not a binary graph file";
+        return false;
+    }
+    if (header.version != BINARY_VERSION)
+    {
+        error = "unsupported binary version " + to_string(header.version);
+        return false;
+    }
+    if (header.n >= INT_MAX || header.m > INT_MAX
+        || size != sizeof(header) + (header.n + 1 + header.m) * sizeof(int))
+    {
+        error = "binary size does not match the header";
+        return false;
+    }
+
+    const char *data = begin + sizeof(header);
+    adj.offsets.resize(header.n + 1);
+    adj.targets.resize(header.m);
+    memcpy(adj.offsets.data(), data, adj.offsets.size() * sizeof(int));
+    memcpy(adj.targets.data(), data + adj.offsets.size() * sizeof(int),
+           adj.targets.size() * sizeof(int));
+
+    if (checksum(adj) != header.checksum)
+    {
+        error = "binary checksum mismatch";
+        return false;
+    }
+
+    const int n = header.n;
+    bool valid = adj.offsets[0] == 0 && adj.offsets[n] == (int) header.m;
+    for (int v = 0; v < n; v++)
+        valid &= adj.offsets[v] <= adj.offsets[v + 1];
+    for (const int v : adj.targets)
+        valid &= v >= 0 && v < n;
+    if (!valid)
+    {
+        error = "invalid binary arrays";
+        return false;
+    }
+
+    return true;
+}
+
+bool util::write_binary(const string &fname, const CSR &adj)
+{
+    const vector<char> out = util::to_binary(adj);
+    ofstream file(fname, ios::binary);
+    if (!file.is_open())
+    {
+        cout << "unable to open file: " << fname << endl;
+        return false;
+    }
+
+    file.write(out.data(), out.size());
+    file.close();
+    if (!file)
+    {
+        cout << "unable to write file: " << fname << endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool parse_bytes(const char *begin,
+                        const char *end,
+                        CSR &adj,
+                        string &error,
+                        Graph_format format)
+{
+    /* binary files regardless of the format */
+    const Graph_format detected = util::detect_format(begin, end);
+    if (format == AUTO || detected == BINARY)
+        format = detected;
+
+    switch (format)
+    {
+    case BINARY:
+        return util::parse_binary(begin, end, adj, error);
+    case EDGE_LIST:
+        return util::parse_edge_list(begin, end, adj, error);
+    case DIGRAPH6:
+        return util::parse_digraph6(begin, end, adj, error);
+    case GRAPH6:
+        return util::parse_graph6(begin, end, adj, error);
+    case DIMACS:
+        return util::parse_dimacs(begin, end, adj, error);
+    default:
+        return util::parse_graph(begin, end, adj, error);
+    }
+}
+
+/* pipes and such cannot be mapped, read them to memory */
+static bool read_stream(const int fd, vector<char> &buf)
+{
+    char block[1 << 16];
+    ssize_t r;
+    while ((r = read(fd, block, sizeof(block))) > 0)
+        buf.insert(buf.end(), block, block + r);
+    return r == 0;
+}
+
+bool util::parse_file(const string &fname,
+                      CSR &adj,
+                      const Graph_format format)
+{
+    /* - is stdin */
+    const bool std_in = fname == "-";
+    const int fd = (std_in) ? STDIN_FILENO : open(fname.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        cout << "unable to open file: " << fname << endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        if (!std_in)
+            close(fd);
+        cout << "unable to open file: " << fname << endl;
+        return false;
+    }
+
+    string error;
+    bool ok;
+    if (!S_ISREG(st.st_mode))
+    {
+        vector<char> buf;
+        ok = read_stream(fd, buf);
+        if (!ok)
+            error = "read failed";
+        else
+            ok = parse_bytes(buf.data(), buf.data() + buf.size(),
+                             adj, error, format);
+    }
+    else if (st.st_size == 0)
+    {
+        ok = parse_bytes(nullptr, nullptr, adj, error, format);
+    }
+    else
+    {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            if (!std_in)
+                close(fd);
+            cout << "unable to map file: " << fname << endl;
+            return false;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+        const char *begin = (const char *) data;
+        ok = parse_bytes(begin, begin + st.st_size, adj, error, format);
+        munmap(data, st.st_size);
+    }
+    if (!std_in)
+        close(fd);
+
+    if (!ok)
+        cout << "invalid graph file " << fname << ", " << error << endl;
+
+    return ok;
+}
+
+bool Graph_reader::next_line(const char *&begin, const char *&end)
+{
+    while (true)
+    {
+        const char *start = this->buf.data() + this->pos;
+        const char *nl = (const char *)
+            memchr(start, '\n', this->len - this->pos);
+
+        if (nl || (this->eof && this->pos < this->len))
+        {
+            begin = start;
+            end = (nl) ? nl : this->buf.data() + this->len;
+            this->pos = (nl) ? nl - this->buf.data() + 1 : this->len;
+
+            while (begin < end && is_space(*begin))
+                begin++;
+            while (end > begin && is_space(end[-1]))
+                end--;
+            if (begin < end)
+                return true;
+            continue;
+        }
+
+        if (this->eof)
+            return false;
+
+        /* the partial line to the front, then read more */
+        memmove(this->buf.data(), start, this->len - this->pos);
+        this->len -= this->pos;
+        this->pos = 0;
+        if (this->len == this->buf.size())
+            this->buf.resize(2 * this->buf.size());
+
+        const ssize_t r = read(this->fd, this->buf.data() + this->len,
+                               this->buf.size() - this->len);
+        if (r < 0)
+        {
+            this->error = "read failed";
+            return false;
+        }
+        this->eof = r == 0;
+        this->len += r;
+    }
+}
+
+bool Graph_reader::next_matrix(const char *begin, const char *end, CSR &adj)
+{
+    long n;
+    if (!scan_id(begin, end, n) || begin != end)
+    {
+        this->error = "expected the vertex count";
+        return false;
+    }
+
+    adj = CSR();
+    adj.offsets.reserve(n + 1);
+    for (int u = 0; u < n; u++)
+    {
+        if (!this->next_line(begin, end) || end - begin != n)
+        {
+            if (this->error.empty())
+                this->error = "expected a row of " + to_string(n) + " bits";
+            return false;
+        }
+        for (int v = 0; v < n; v++)
+            if (begin[v] == '1')
+                adj.targets.push_back(v);
+        adj.offsets.push_back(adj.targets.size());
+    }
+
+    return true;
+}
+
+bool Graph_reader::next(CSR &adj)
+{
+    const char *begin;
+    const char *end;
+    if (!this->next_line(begin, end))
+        return false;
+    this->graphs++;
+
+    if (this->format == AUTO)
+    {
+        this->format = util::detect_format(begin, end);
+        this->matrices = this->format == LINES;
+    }
+
+    bool ok;
+    if (this->matrices)
+        ok = this->next_matrix(begin, end, adj);
+    else if (this->format == DIGRAPH6)
+        ok = util::parse_digraph6(begin, end, adj, this->error);
+    else if (this->format == GRAPH6)
+        ok = util::parse_graph6(begin, end, adj, this->error);
+    else
+    {
+        this->error = "expected digraph6, graph6 or listg -a matrices";
+        ok = false;
+    }
+
+    if (!ok)
+        this->error = "graph " + to_string(this->graphs) + ": " + this->error;
+
+    return ok;
+}
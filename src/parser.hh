@@ -0,0 +1,141 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "csr.hh"
+
+/* syntaxes of the graph files. binary files are recognized
+ * from the magic regardless of the format */
+enum Graph_format
+{
+    /* detected from the first bytes, see util::detect_format */
+    AUTO,
+    /* line i lists the out-neighbours of vertex i, see the readme */
+    LINES,
+    /* one arc "u v" per line */
+    EDGE_LIST,
+    /* the first graph of a digraph6 file, the output of nauty directg */
+    DIGRAPH6,
+    /* the first graph of a graph6 file, the output of nauty geng.
+     * each edge is an arc both ways */
+    GRAPH6,
+    /* "c" comments, "p <problem> n m", then "a u v" arcs or
+     * "e u v" edges with ids from 1 */
+    DIMACS,
+    /* Binary_header and the CSR arrays, written by digraph-convert */
+    BINARY
+};
+
+/* binary graph files are this header followed by the n + 1 offsets
+ * and the m targets of the CSR as 32-bit integers in the byte order
+ * of the machine, ie. little endian on x86-64 */
+struct Binary_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t n;
+    uint64_t m;
+    /* of the offsets and the targets */
+    uint64_t checksum;
+};
+
+constexpr char BINARY_MAGIC[8] = { 'D', 'I', 'G', 'R', 'C', 'S', 'R', '\0' };
+constexpr uint32_t BINARY_VERSION = 1;
+
+namespace util
+{
+    /* maps the file to memory and parses it straight to adj. stdin
+     * is "-" and read in large blocks. prints a message and returns
+     * false on errors */
+    bool parse_file(const std::string &fname,
+                    CSR &adj,
+                    const Graph_format format = AUTO);
+
+    /* the edge list is never detected, it looks like the line syntax */
+    Graph_format detect_format(const char *begin, const char *end);
+
+    /* the line syntax for the bytes in [begin, end). lines starting
+     * with '#' are comments. large inputs are split at newlines to chunks
+     * parsed in parallel, chunks = 0 picks the amount from the thread
+     * count. the message of a failure goes to error */
+    bool parse_graph(const char *begin,
+                     const char *end,
+                     CSR &adj,
+                     std::string &error,
+                     int chunks = 0);
+
+    /* lines starting with '#' or '%' are comments. the vertices are
+     * 0, 1, .., the largest id */
+    bool parse_edge_list(const char *begin,
+                         const char *end,
+                         CSR &adj,
+                         std::string &error);
+
+    bool parse_digraph6(const char *begin,
+                        const char *end,
+                        CSR &adj,
+                        std::string &error);
+
+    bool parse_graph6(const char *begin,
+                      const char *end,
+                      CSR &adj,
+                      std::string &error);
+
+    bool parse_dimacs(const char *begin,
+                      const char *end,
+                      CSR &adj,
+                      std::string &error);
+
+    /* validates the header, the checksum and the arrays */
+    bool parse_binary(const char *begin,
+                      const char *end,
+                      CSR &adj,
+                      std::string &error);
+
+    std::vector<char> to_binary(const CSR &adj);
+
+    /* prints a message and returns false on errors */
+    bool write_binary(const std::string &fname, const CSR &adj);
+}
+
+/* graphs one by one from a stream of digraph6 or graph6 lines, the
+ * output of nauty directg and geng, or of the adjacency matrices of
+ * listg -a, ie. n on a line followed by n rows of 0s and 1s. the format
+ * is detected from the first graph and the input is read in large blocks */
+class Graph_reader
+{
+private:
+    int fd;
+    std::vector<char> buf;
+    /* the unread bytes are buf[pos], .., buf[len - 1] */
+    size_t pos;
+    size_t len;
+    bool eof;
+    Graph_format format;
+    /* listg -a matrices */
+    bool matrices;
+    long graphs;
+    std::string error;
+
+    /* the next nonempty line without the newline */
+    bool next_line(const char *&begin, const char *&end);
+
+    bool next_matrix(const char *begin, const char *end, CSR &adj);
+
+public:
+    explicit Graph_reader(const int fd): fd(fd), buf(1 << 20), pos(0),
+        len(0), eof(false), format(AUTO), matrices(false), graphs(0) {}
+
+    /* false at the end of the stream or on errors */
+    bool next(CSR &adj);
+
+    /* empty at the end of the stream */
+    const std::string &get_error() const { return this->error; }
+};
+
+#endif
@@ -1,27 +1,37 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <vector>
+#include <cassert>
 
 #include "polynomial.hh"
 #include "global.hh"
 
 using namespace std;
 
+/* below these sizes the quadratic algorithms are faster */
+constexpr int KARATSUBA_THRESHOLD = 32;
+constexpr int NEWTON_THRESHOLD = 256;
+/* points in the leaves of the subproduct tree */
+constexpr int LEAF = 32;
+constexpr int FAST_INTERPOLATION_THRESHOLD = 64;
+
 /* divides this by monomial (x + v) using synthetic division */
-void Polynomial::div(const GF_element &v)
+template <typename F>
+void Polynomial<F>::div(const GF_element<F> &v)
 {
-    GF_element prev = this->coeffs[this->deg];
-    this->coeffs[this->deg] = util::GF_zero();
+    GF_element<F> prev = this->coeffs[this->deg];
+    this->coeffs[this->deg] = util::GF_zero<F>();
 
     for (int i = this->deg - 1; i >= 0; i--)
     {
-        const GF_element tmp = this->coeffs[i];
+        const GF_element<F> tmp = this->coeffs[i];
         this->coeffs[i] = prev;
         prev *= v;
         prev += tmp;
     }
 }
 
-Polynomial &Polynomial::operator*=(const GF_element &other)
+template <typename F>
+Polynomial<F> &Polynomial<F>::operator*=(const GF_element<F> &other)
 {
     for (int i = 0; i <= this->deg; i++)
         this->coeffs[i] *= other;
@@ -29,7 +39,8 @@ Polynomial &Polynomial::operator*=(const GF_element &other)
     return *this;
 }
 
-Polynomial &Polynomial::operator+=(const Polynomial &other)
+template <typename F>
+Polynomial<F> &Polynomial<F>::operator+=(const Polynomial<F> &other)
 {
     // assert(this->deg == other.deg)
     for (int i = 0; i <= this->deg; i++)
@@ -38,56 +49,658 @@ Polynomial &Polynomial::operator+=(const Polynomial &other)
     return *this;
 }
 
-namespace util
+/* out[0..2n-2] += a*b where a and b have n coefficients. scratch
+ * needs room for 16n elements. */
+template <typename F>
+static void karatsuba(const GF_element<F> *a,
+                      const GF_element<F> *b,
+                      const int n,
+                      GF_element<F> *out,
+                      GF_element<F> *scratch
+)
 {
-    /* la grange interpolation with gamma and delta
-     * note that we are in characteristic 2 and thus
-     * - = +. done with the formula (3.3) here:
-     * https://doi.org/10.1137/S0036144502417715 */
-    Polynomial poly_interpolation(
-        const std::vector<GF_element> &gamma,
-        const std::vector<GF_element> &delta
-        )
+    if (n <= KARATSUBA_THRESHOLD)
+    {
+        /* the carryless products are summed before reducing,
+         * they fit in 64 bits for n <= 32 */
+        uint64_t acc[2*KARATSUBA_THRESHOLD - 1] = { };
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                acc[i + j] ^= F::clmul(
+                    a[i].get_repr(),
+                    b[j].get_repr()
+                );
+        for (int i = 0; i < 2*n - 1; i++)
+            out[i] += GF_element<F>(F::rem(acc[i]));
+        return;
+    }
+
+    /* a = a0 + x^h*a1, where a1 has m >= h coefficients */
+    const int h = n / 2;
+    const int m = n - h;
+
+    GF_element<F> *z0 = scratch;
+    GF_element<F> *z1 = z0 + 2*m;
+    GF_element<F> *z2 = z1 + 2*m;
+    GF_element<F> *as = z2 + 2*m;
+    GF_element<F> *bs = as + m;
+    GF_element<F> *rest = bs + m;
+    for (int i = 0; i < 6*m; i++)
+        z0[i] = util::GF_zero<F>();
+
+    karatsuba(a, b, h, z0, rest);
+    karatsuba(a + h, b + h, m, z2, rest);
+
+    for (int i = 0; i < m; i++)
+    {
+        as[i] = a[h + i];
+        bs[i] = b[h + i];
+    }
+    for (int i = 0; i < h; i++)
+    {
+        as[i] += a[i];
+        bs[i] += b[i];
+    }
+    karatsuba(as, bs, m, z1, rest);
+
+    /* in characteristic two the middle term is z1 + z0 + z2 */
+    for (int i = 0; i < 2*h - 1; i++)
+    {
+        z1[i] += z0[i];
+        out[i] += z0[i];
+    }
+    for (int i = 0; i < 2*m - 1; i++)
+    {
+        z1[i] += z2[i];
+        out[2*h + i] += z2[i];
+    }
+    for (int i = 0; i < 2*m - 1; i++)
+        out[h + i] += z1[i];
+}
+
+template <typename F>
+Polynomial<F> Polynomial<F>::operator*(const Polynomial<F> &other) const
+{
+    const bool longer = this->deg >= other.get_deg();
+    const vector<GF_element<F>> &a = (longer) ? this->coeffs : other.coeffs;
+    const vector<GF_element<F>> &b = (longer) ? other.coeffs : this->coeffs;
+    const int na = a.size();
+    const int nb = b.size();
+
+    /* split a to pieces of the length of b */
+    const int pieces = (na + nb - 1) / nb;
+    vector<GF_element<F>> prod(pieces*nb + nb - 1);
+    vector<GF_element<F>> piece(nb);
+    vector<GF_element<F>> scratch(16*nb);
+    for (int p = 0; p < pieces; p++)
+    {
+        for (int i = 0; i < nb; i++)
+            piece[i] = (p*nb + i < na) ? a[p*nb + i] : util::GF_zero<F>();
+        karatsuba(piece.data(), b.data(), nb, prod.data() + p*nb,
+                  scratch.data());
+    }
+
+    prod.resize(na + nb - 1);
+    return Polynomial<F>(prod);
+}
+
+template <typename F>
+Polynomial<F> Polynomial<F>::operator%(const Polynomial<F> &mod) const
+{
+    const int dm = mod.get_deg();
+    if (this->deg < dm)
+        return *this;
+    if (dm == 0)
+        return Polynomial<F>(0);
+
+    /* length of the quotient */
+    const int k = this->deg - dm + 1;
+
+    if (k <= NEWTON_THRESHOLD || dm <= NEWTON_THRESHOLD)
+    {
+        vector<GF_element<F>> r(this->coeffs);
+        for (int i = this->deg; i >= dm; i--)
+        {
+            const GF_element<F> c = r[i];
+            if (c == util::GF_zero<F>())
+                continue;
+            for (int j = 0; j < dm; j++)
+                r[i - dm + j] += c * mod[j];
+        }
+        r.resize(dm);
+        return Polynomial<F>(r);
+    }
+
+    /* reversing the division relation a = q*mod + r gives
+     * rev(q) = rev(a) / rev(mod) mod x^k */
+    vector<GF_element<F>> rev_mod(dm + 1);
+    for (int i = 0; i <= dm; i++)
+        rev_mod[i] = mod[dm - i];
+    const Polynomial<F> inv = Polynomial<F>(rev_mod).inv_series(k);
+
+    vector<GF_element<F>> rev_a(k);
+    for (int i = 0; i < k; i++)
+        rev_a[i] = this->coeffs[this->deg - i];
+    const Polynomial<F> rev_q = Polynomial<F>(rev_a) * inv;
+
+    vector<GF_element<F>> q(k);
+    for (int i = 0; i < k; i++)
+        q[i] = rev_q[k - 1 - i];
+    const Polynomial<F> qm = Polynomial<F>(q) * mod;
+
+    vector<GF_element<F>> r(dm);
+    for (int i = 0; i < dm; i++)
+        r[i] = this->coeffs[i] + qm[i];
+    return Polynomial<F>(r);
+}
+
+template <typename F>
+Polynomial<F> Polynomial<F>::derivative() const
+{
+    if (this->deg == 0)
+        return Polynomial<F>(0);
+
+    /* in characteristic two only the odd powers remain */
+    Polynomial<F> der(this->deg - 1);
+    for (int i = 1; i <= this->deg; i += 2)
+        der(i - 1, this->coeffs[i]);
+    return der;
+}
+
+template <typename F>
+Polynomial<F> Polynomial<F>::inv_series(const int k) const
+{
+    /* newton iteration g <- 2g - f*g^2, which is f*g^2 here */
+    vector<GF_element<F>> g(1, util::GF_one<F>());
+    int len = 1;
+    while (len < k)
+    {
+        len = min(2*len, k);
+        vector<GF_element<F>> f(len);
+        for (int i = 0; i < len && i <= this->deg; i++)
+            f[i] = this->coeffs[i];
+
+        const Polynomial<F> gg = Polynomial<F>(g) * Polynomial<F>(g);
+        const Polynomial<F> fgg = Polynomial<F>(f) * gg;
+        g.resize(len);
+        for (int i = 0; i < len; i++)
+            g[i] = fgg[i];
+    }
+    g.resize(k);
+    return Polynomial<F>(g);
+}
+
+template <typename F>
+Subproduct_tree<F>::Subproduct_tree(const vector<GF_element<F>> &points):
+    points(points),
+    nodes(4*(points.size() / LEAF + 1), Polynomial<F>(0))
+{
+    this->build(1, 0, points.size());
+}
+
+template <typename F>
+void Subproduct_tree<F>::build(const int node, const int lo, const int hi)
+{
+    if (hi - lo <= LEAF)
+    {
+        /* prod_{lo <= i < hi} (x + gamma_i) */
+        vector<GF_element<F>> P(hi - lo + 1);
+        P[0] = util::GF_one<F>();
+        for (int i = lo; i < hi; i++)
+        {
+            for (int j = i - lo + 1; j > 0; j--)
+                P[j] = P[j - 1] + P[j] * this->points[i];
+            P[0] *= this->points[i];
+        }
+        this->nodes[node] = Polynomial<F>(P);
+        return;
+    }
+
+    const int mid = (lo + hi) / 2;
+    this->build(2*node, lo, mid);
+    this->build(2*node + 1, mid, hi);
+    this->nodes[node] = this->nodes[2*node] * this->nodes[2*node + 1];
+}
+
+template <typename F>
+void Subproduct_tree<F>::evaluate(const Polynomial<F> &p,
+                                  const int node,
+                                  const int lo,
+                                  const int hi,
+                                  vector<GF_element<F>> &values) const
+{
+    const Polynomial<F> r = p % this->nodes[node];
+    if (hi - lo <= LEAF)
     {
-        // assert(gamma.size() == delta.size())
-        // assert(n > 2)
-        int n = gamma.size();
+        for (int i = lo; i < hi; i++)
+            values[i] = r.eval(this->points[i]);
+        return;
+    }
+
+    const int mid = (lo + hi) / 2;
+    this->evaluate(r, 2*node, lo, mid, values);
+    this->evaluate(r, 2*node + 1, mid, hi, values);
+}
+
+template <typename F>
+vector<GF_element<F>>
+Subproduct_tree<F>::evaluate(const Polynomial<F> &p) const
+{
+    vector<GF_element<F>> values(this->points.size());
+    this->evaluate(p, 1, 0, this->points.size(), values);
+    return values;
+}
 
-        /* weights*/
-        std::vector<GF_element> w(n, util::GF_one());
-        for (int j = 1; j < n; j++)
+/* sum of c_i * M / (x + gamma_i) over the points of the node,
+ * where M is the polynomial of the node */
+template <typename F>
+Polynomial<F> Subproduct_tree<F>::combine(const vector<GF_element<F>> &c,
+                                          const int node,
+                                          const int lo,
+                                          const int hi) const
+{
+    if (hi - lo <= LEAF)
+    {
+        const Polynomial<F> &M = this->nodes[node];
+        const int d = hi - lo;
+        Polynomial<F> sum(d - 1);
+        for (int i = lo; i < hi; i++)
         {
-            for (int k = 0; k < j; k++)
+            /* synthetic division by (x + gamma_i) */
+            GF_element<F> prev = M[d];
+            for (int j = d - 1; j >= 0; j--)
             {
-                w[k] *= gamma[k] + gamma[j];
-                w[j] *= gamma[k] + gamma[j];
+                sum(j, sum[j] + prev * c[i]);
+                prev *= this->points[i];
+                prev += M[j];
             }
         }
+        return sum;
+    }
+
+    const int mid = (lo + hi) / 2;
+    Polynomial<F> sum =
+        this->combine(c, 2*node, lo, mid) * this->nodes[2*node + 1];
+    sum += this->combine(c, 2*node + 1, mid, hi) * this->nodes[2*node];
+    return sum;
+}
+
+template <typename F>
+vector<GF_element<F>> Subproduct_tree<F>::weights() const
+{
+    vector<GF_element<F>> w = this->evaluate(this->root().derivative());
+    util::batch_inverse(w);
+    return w;
+}
 
-        for (int j = 0; j < n; j++)
-            w[j].inv_in_place();
+template <typename F>
+Polynomial<F>
+Subproduct_tree<F>::interpolate(const vector<GF_element<F>> &values) const
+{
+    return this->interpolate(values, this->weights());
+}
+
+template <typename F>
+Polynomial<F>
+Subproduct_tree<F>::interpolate(const vector<GF_element<F>> &values,
+                                const vector<GF_element<F>> &weights) const
+{
+    vector<GF_element<F>> c(values.size());
+    for (uint i = 0; i < c.size(); i++)
+        c[i] = values[i] * weights[i];
+
+    return this->combine(c, 1, 0, this->points.size());
+}
 
-        /* main polynomial [ prod_{i} (x + gamma_i) ]
-         * GF_element default constructs to zero. */
-        std::vector<GF_element> P(n+1);
-        P[n] += util::GF_one();
-        P[n-1] += gamma[0];
-        for (int i = 1; i < n; i++)
+template <typename F>
+Additive_FFT<F>::Additive_FFT(const int k): k(k), s(k + 1), e(k), e_inv(k)
+{
+    /* the subspace of 2^k elements has to fit in the field */
+    assert(k <= F::get_n());
+    /* s_0(x) = x and s_{j+1}(x) = s_j(x) s_j(x + x^j)
+     * = s_j(x)^2 + s_j(x^j) s_j(x), as s_j is linear */
+    this->s[0] = { util::GF_one<F>() };
+    for (int j = 0; j < k; j++)
+    {
+        this->e[j] = this->eval_s(j, GF_element<F>(1ull << j));
+
+        this->s[j + 1].resize(j + 2);
+        for (int t = 0; t <= j + 1; t++)
         {
-            for (int j = n - i - 1; j < n - 1; j++)
-                P[j] += gamma[i] * P[j+1];
-            P[n - 1] += gamma[i];
+            GF_element<F> c = util::GF_zero<F>();
+            if (t > 0)
+                c += this->s[j][t - 1] * this->s[j][t - 1];
+            if (t <= j)
+                c += this->e[j] * this->s[j][t];
+            this->s[j + 1][t] = c;
         }
+    }
 
-        Polynomial interp(n - 1);
-        for (int i = 0; i < n; i++)
+    this->e_inv = this->e;
+    util::batch_inverse(this->e_inv);
+}
+
+template <typename F>
+GF_element<F> Additive_FFT<F>::eval_s(const int j, const GF_element<F> &c) const
+{
+    GF_element<F> val = util::GF_zero<F>();
+    GF_element<F> pow = c;
+    for (int t = 0; t <= j; t++)
+    {
+        val += this->s[j][t] * pow;
+        pow = pow.square();
+    }
+    return val;
+}
+
+template <typename F>
+void Additive_FFT<F>::fft(vector<GF_element<F>> f,
+                          const int j,
+                          const uint64_t c,
+                          GF_element<F> *values) const
+{
+    if (j == 0)
+    {
+        values[0] = f[0];
+        return;
+    }
+
+    const int h = 1 << (j - 1);
+    const vector<GF_element<F>> &sj = this->s[j - 1];
+
+    /* f = q s_{j-1} + r, q is left to the upper half of f.
+     * s_{j-1} is monic with the rest of the terms at x^(2^t) */
+    for (int i = 2*h - 1; i >= h; i--)
+        for (int t = 0; t < j - 1; t++)
+            f[i - h + (1 << t)] += f[i] * sj[t];
+
+    /* the halves are c + V_{j-1} and c + x^(j-1) + V_{j-1},
+     * where s_{j-1} is d_lo and d_lo + s_{j-1}(x^(j-1)) */
+    const GF_element<F> d_lo = this->eval_s(j - 1, GF_element<F>(c));
+    vector<GF_element<F>> lo(h);
+    vector<GF_element<F>> hi(h);
+    for (int i = 0; i < h; i++)
+    {
+        lo[i] = f[i] + f[i + h] * d_lo;
+        hi[i] = lo[i] + f[i + h] * this->e[j - 1];
+    }
+
+    this->fft(move(lo), j - 1, c, values);
+    this->fft(move(hi), j - 1, c | h, values + h);
+}
+
+template <typename F>
+vector<GF_element<F>> Additive_FFT<F>::ifft(const GF_element<F> *values,
+                                            const int j,
+                                            const uint64_t c) const
+{
+    if (j == 0)
+        return { values[0] };
+
+    const int h = 1 << (j - 1);
+    const vector<GF_element<F>> &sj = this->s[j - 1];
+    const vector<GF_element<F>> lo = this->ifft(values, j - 1, c);
+    const vector<GF_element<F>> hi = this->ifft(values + h, j - 1, c | h);
+    const GF_element<F> d_lo = this->eval_s(j - 1, GF_element<F>(c));
+
+    /* lo = r + q d_lo and hi = r + q (d_lo + s_{j-1}(x^(j-1))),
+     * then f = q s_{j-1} + r */
+    vector<GF_element<F>> f(2*h);
+    for (int i = 0; i < h; i++)
+    {
+        const GF_element<F> q = (lo[i] + hi[i]) * this->e_inv[j - 1];
+        f[i] += lo[i] + q * d_lo;
+        f[i + h] += q;
+        for (int t = 0; t < j - 1; t++)
+            f[i + (1 << t)] += q * sj[t];
+    }
+
+    return f;
+}
+
+template <typename F>
+vector<GF_element<F>> Additive_FFT<F>::interpolate(const GF_element<F> *values,
+                                                   const int m,
+                                                   const int j,
+                                                   const uint64_t c) const
+{
+    if (m == (1 << j))
+        return this->ifft(values, j, c);
+
+    const int h = 1 << (j - 1);
+    if (m <= h)
+        return this->interpolate(values, m, j - 1, c);
+
+    /* f = q (s_{j-1} + d_lo) + r. at the first half f = r, which
+     * is a full inverse transform. at the rest of the points
+     * s_{j-1} + d_lo = s_{j-1}(x^(j-1)), so q is interpolated
+     * from f - r there */
+    const vector<GF_element<F>> &sj = this->s[j - 1];
+    const vector<GF_element<F>> r = this->ifft(values, j - 1, c);
+    vector<GF_element<F>> qv(h);
+    this->fft(r, j - 1, c | h, qv.data());
+    for (int i = 0; i < m - h; i++)
+        qv[i] = (values[h + i] + qv[i]) * this->e_inv[j - 1];
+    const vector<GF_element<F>> q =
+        this->interpolate(qv.data(), m - h, j - 1, c | h);
+
+    const GF_element<F> d_lo = this->eval_s(j - 1, GF_element<F>(c));
+    vector<GF_element<F>> f(r);
+    f.resize(m);
+    for (int i = 0; i < m - h; i++)
+    {
+        f[i] += q[i] * d_lo;
+        f[i + h] += q[i];
+        for (int t = 0; t < j - 1; t++)
+            f[i + (1 << t)] += q[i] * sj[t];
+    }
+
+    return f;
+}
+
+template <typename F>
+vector<GF_element<F>> Additive_FFT<F>::evaluate(const Polynomial<F> &p) const
+{
+    vector<GF_element<F>> f(1 << this->k);
+    for (int i = 0; i <= p.get_deg(); i++)
+        f[i] = p[i];
+
+    vector<GF_element<F>> values(1 << this->k);
+    this->fft(move(f), this->k, 0, values.data());
+    return values;
+}
+
+template <typename F>
+Polynomial<F>
+Additive_FFT<F>::interpolate(const vector<GF_element<F>> &values) const
+{
+    return Polynomial<F>(
+        this->interpolate(values.data(), values.size(), this->k, 0)
+    );
+}
+
+/* la grange interpolation with gamma and delta
+ * note that we are in characteristic 2 and thus
+ * - = +. done with the formula (3.3) here:
+ * https://doi.org/10.1137/S0036144502417715 */
+template <typename F>
+static vector<GF_element<F>>
+lagrange_weights(const vector<GF_element<F>> &gamma)
+{
+    const int n = gamma.size();
+
+    vector<GF_element<F>> w(n, util::GF_one<F>());
+    for (int j = 1; j < n; j++)
+    {
+        for (int k = 0; k < j; k++)
+        {
+            w[k] *= gamma[k] + gamma[j];
+            w[j] *= gamma[k] + gamma[j];
+        }
+    }
+
+    util::batch_inverse(w);
+    return w;
+}
+
+/* prod_{i} (x + gamma_i) */
+template <typename F>
+static vector<GF_element<F>> main_polynomial(const vector<GF_element<F>> &gamma)
+{
+    const int n = gamma.size();
+
+    /* GF_element<F> default constructs to zero */
+    vector<GF_element<F>> P(n+1);
+    P[n] += util::GF_one<F>();
+    P[n-1] += gamma[0];
+    for (int i = 1; i < n; i++)
+    {
+        for (int j = n - i - 1; j < n - 1; j++)
+            P[j] += gamma[i] * P[j+1];
+        P[n - 1] += gamma[i];
+    }
+
+    return P;
+}
+
+/* synthetic division of P by (x + gamma_i) summed
+ * straight to the result */
+template <typename F>
+static Polynomial<F> lagrange_combine(const vector<GF_element<F>> &gamma,
+                                      const vector<GF_element<F>> &w,
+                                      const vector<GF_element<F>> &P,
+                                      const vector<GF_element<F>> &delta)
+{
+    const int n = gamma.size();
+
+    Polynomial<F> interp(n - 1);
+    for (int i = 0; i < n; i++)
+    {
+        const GF_element<F> c = w[i] * delta[i];
+        GF_element<F> prev = P[n];
+        for (int j = n - 1; j >= 0; j--)
         {
-            Polynomial tmp(P);
-            tmp.div(gamma[i]);
-            tmp *= w[i] * delta[i];
-            interp += tmp;
+            interp(j, interp[j] + prev * c);
+            prev *= gamma[i];
+            prev += P[j];
         }
+    }
+
+    return interp;
+}
+
+static int ceil_log2(const int m)
+{
+    int k = 0;
+    while ((1 << k) < m)
+        k++;
+    return k;
+}
 
-        return interp;
+template <typename F>
+Interpolation_plan<F>::Interpolation_plan(const int m,
+                                          const Interpolation_mode mode):
+    mode(mode), fft(mode == SUBSPACE_POINTS ? ceil_log2(m) : 0)
+{
+    if (mode == SUBSPACE_POINTS)
+    {
+        this->points = util::subspace_elements<F>(m);
+    }
+    else
+    {
+        this->points = util::distinct_elements<F>(m);
+        this->init_weights();
     }
 }
+
+template <typename F>
+Interpolation_plan<F>::Interpolation_plan(const vector<GF_element<F>> &points):
+    mode(RANDOM_POINTS), points(points), fft(0)
+{
+    this->init_weights();
+}
+
+template <typename F>
+void Interpolation_plan<F>::init_weights()
+{
+    if (this->points.size() < FAST_INTERPOLATION_THRESHOLD)
+    {
+        this->weights = lagrange_weights(this->points);
+        this->main_poly = main_polynomial(this->points);
+    }
+    else
+    {
+        this->tree = make_unique<Subproduct_tree<F>>(this->points);
+        this->weights = this->tree->weights();
+    }
+}
+
+template <typename F>
+Polynomial<F>
+Interpolation_plan<F>::interpolate(const vector<GF_element<F>> &values) const
+{
+    if (this->mode == SUBSPACE_POINTS)
+        return this->fft.interpolate(values);
+    if (this->tree)
+        return this->tree->interpolate(values, this->weights);
+    return lagrange_combine(this->points, this->weights, this->main_poly, values);
+}
+
+namespace util
+{
+    template <typename F>
+    Polynomial<F> poly_interpolation(
+        const std::vector<GF_element<F>> &gamma,
+        const std::vector<GF_element<F>> &delta
+        )
+    {
+        return Interpolation_plan<F>(gamma).interpolate(delta);
+    }
+
+    template <typename F>
+    Polynomial<F> poly_interpolation_lagrange(
+        const std::vector<GF_element<F>> &gamma,
+        const std::vector<GF_element<F>> &delta
+        )
+    {
+        return lagrange_combine(gamma,
+                                lagrange_weights(gamma),
+                                main_polynomial(gamma),
+                                delta);
+    }
+}
+
+template class Polynomial<GF2_16>;
+template class Polynomial<GF2_32>;
+template class Polynomial<GF2_generic>;
+template class Subproduct_tree<GF2_16>;
+template class Subproduct_tree<GF2_32>;
+template class Subproduct_tree<GF2_generic>;
+template class Additive_FFT<GF2_16>;
+template class Additive_FFT<GF2_32>;
+template class Additive_FFT<GF2_generic>;
+template class Interpolation_plan<GF2_16>;
+template class Interpolation_plan<GF2_32>;
+template class Interpolation_plan<GF2_generic>;
+
+namespace util
+{
+    template Polynomial<GF2_16> poly_interpolation(
+        const std::vector<GF_element<GF2_16>> &,
+        const std::vector<GF_element<GF2_16>> &);
+    template Polynomial<GF2_32> poly_interpolation(
+        const std::vector<GF_element<GF2_32>> &,
+        const std::vector<GF_element<GF2_32>> &);
+    template Polynomial<GF2_generic> poly_interpolation(
+        const std::vector<GF_element<GF2_generic>> &,
+        const std::vector<GF_element<GF2_generic>> &);
+    template Polynomial<GF2_16> poly_interpolation_lagrange(
+        const std::vector<GF_element<GF2_16>> &,
+        const std::vector<GF_element<GF2_16>> &);
+    template Polynomial<GF2_32> poly_interpolation_lagrange(
+        const std::vector<GF_element<GF2_32>> &,
+        const std::vector<GF_element<GF2_32>> &);
+    template Polynomial<GF2_generic> poly_interpolation_lagrange(
+        const std::vector<GF_element<GF2_generic>> &,
+        const std::vector<GF_element<GF2_generic>> &);
+}
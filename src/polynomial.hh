@@ -4,49 +4,65 @@
 
 #include <vector>
 #include <iostream>
+#include <memory>
 
 #include "gf.hh"
 
+template <typename F>
 class Polynomial
 {
 private:
-    std::vector<GF_element> coeffs;
-    const int deg;
+    std::vector<GF_element<F>> coeffs;
+    int deg;
 
 public:
     /* be lazy and just store coefficients in vector of length n.
      * dont care if some of the coefficients are zero */
     explicit Polynomial(const int n): coeffs(n+1), deg(n) {};
-    explicit Polynomial(const std::vector<GF_element> &P):
+    explicit Polynomial(const std::vector<GF_element<F>> &P):
         coeffs(P), deg(P.size() - 1) {};
 
-    void div(const GF_element &v);
+    void div(const GF_element<F> &v);
 
-    Polynomial &operator*=(const GF_element &other);
+    Polynomial &operator*=(const GF_element<F> &other);
 
     Polynomial &operator+=(const Polynomial &other);
 
-    GF_element operator[](int i) const
+    /* karatsuba */
+    Polynomial operator*(const Polynomial &other) const;
+
+    /* remainder modulo a monic polynomial. long division for
+     * small quotients, otherwise newton iteration */
+    Polynomial operator%(const Polynomial &mod) const;
+
+    /* formal derivative */
+    Polynomial derivative() const;
+
+    /* inverse modulo x^k, the constant coefficient has to be one */
+    Polynomial inv_series(const int k) const;
+
+    GF_element<F> operator[](int i) const
     {
         return this->coeffs[i];
     }
 
     /* set coefficient with deg i to val */
     /* const & for val?? */
-    void operator()(const int i, GF_element val)
+    void operator()(const int i, GF_element<F> val)
     {
         this->coeffs[i] = val;
     }
 
-    /* eval at point x. only used for testing */
-    GF_element eval(const GF_element &x)
+    inline int get_deg() const { return this->deg; }
+
+    /* eval at point x with horner's rule */
+    GF_element<F> eval(const GF_element<F> &x) const
     {
-        GF_element val = this->coeffs[0];
-        GF_element prod = x;
-        for (int i = 1; i <= this->deg; i++)
+        GF_element<F> val = this->coeffs[this->deg];
+        for (int i = this->deg - 1; i >= 0; i--)
         {
-            val += prod * this->coeffs[i];
-            prod *= x;
+            val *= x;
+            val += this->coeffs[i];
         }
         return val;
     }
@@ -61,11 +77,156 @@ public:
     }
 };
 
+/* products of (x + gamma_i) over halves of the points, recursively.
+ * used for multipoint evaluation and interpolation, see
+ * chapter 10 of von zur Gathen and Gerhard, Modern Computer Algebra. */
+template <typename F>
+class Subproduct_tree
+{
+private:
+    std::vector<GF_element<F>> points;
+    /* node i has children 2i and 2i+1, root is 1. the leaves
+     * cover at most LEAF points and are handled directly. */
+    std::vector<Polynomial<F>> nodes;
+
+    void build(const int node, const int lo, const int hi);
+
+    void evaluate(const Polynomial<F> &p,
+                  const int node,
+                  const int lo,
+                  const int hi,
+                  std::vector<GF_element<F>> &values) const;
+
+    Polynomial<F> combine(const std::vector<GF_element<F>> &c,
+                          const int node,
+                          const int lo,
+                          const int hi) const;
+
+public:
+    explicit Subproduct_tree(const std::vector<GF_element<F>> &points);
+
+    /* prod_{i} (x + gamma_i) */
+    const Polynomial<F> &root() const { return this->nodes[1]; }
+
+    /* p at each of the points */
+    std::vector<GF_element<F>> evaluate(const Polynomial<F> &p) const;
+
+    /* lagrange weights 1 / M'(gamma_i), where M is the root */
+    std::vector<GF_element<F>> weights() const;
+
+    /* the polynomial of degree < #points with the values at the points */
+    Polynomial<F> interpolate(const std::vector<GF_element<F>> &values) const;
+
+    /* same with the weights precomputed */
+    Polynomial<F> interpolate(const std::vector<GF_element<F>> &values,
+                              const std::vector<GF_element<F>> &weights) const;
+};
+
+/* evaluation points of the interpolations. random points go through
+ * the subproduct tree or lagrange, subspace points 0, 1, .., m-1 through
+ * the additive fft below */
+enum Interpolation_mode { RANDOM_POINTS, SUBSPACE_POINTS };
+
+/* additive fft of Cantor and von zur Gathen - Gerhard on the points
+ * 0, 1, .., 2^k - 1, ie. the subspace V_k spanned by 1, x, .., x^(k-1).
+ * the tree nodes are the subspace polynomials s_j(x) = prod_{a in V_j} (x + a)
+ * and their translates s_j(x) + s_j(c). s_j is linearized, so it has only
+ * j + 1 nonzero coefficients and the divisions are cheap. no inversions
+ * except the k constants 1 / s_j(x^j) */
+template <typename F>
+class Additive_FFT
+{
+private:
+    int k;
+    /* s[j][t] is the coefficient of x^(2^t) in s_j */
+    std::vector<std::vector<GF_element<F>>> s;
+    /* s_j(x^j) and the inverses */
+    std::vector<GF_element<F>> e;
+    std::vector<GF_element<F>> e_inv;
+
+    GF_element<F> eval_s(const int j, const GF_element<F> &c) const;
+
+    /* values of f with 2^j coefficients at c + V_j */
+    void fft(std::vector<GF_element<F>> f,
+             const int j,
+             const uint64_t c,
+             GF_element<F> *values) const;
+
+    /* inverse of the above */
+    std::vector<GF_element<F>> ifft(const GF_element<F> *values,
+                                    const int j,
+                                    const uint64_t c) const;
+
+    /* the polynomial of degree < m with the values at the
+     * first m points of c + V_j */
+    std::vector<GF_element<F>> interpolate(const GF_element<F> *values,
+                                           const int m,
+                                           const int j,
+                                           const uint64_t c) const;
+
+public:
+    /* for up to 2^k points, k <= n of the field */
+    explicit Additive_FFT(const int k);
+
+    /* p at the 2^k points, p has degree < 2^k */
+    std::vector<GF_element<F>> evaluate(const Polynomial<F> &p) const;
+
+    /* the polynomial of degree < m with the values at 0, 1, .., m-1 */
+    Polynomial<F> interpolate(const std::vector<GF_element<F>> &values) const;
+};
+
+/* the evaluation points and everything about them the interpolation
+ * needs: the weights and the main polynomial prod_{i} (x + gamma_i) of
+ * the lagrange formula, the subproduct tree or the additive fft. built
+ * once outside of the parallel regions, as drawing random points uses
+ * global::randgen, and then shared read-only. */
+template <typename F>
+class Interpolation_plan
+{
+private:
+    Interpolation_mode mode;
+    std::vector<GF_element<F>> points;
+    /* 1 / prod_{j != i} (gamma_i + gamma_j) */
+    std::vector<GF_element<F>> weights;
+    /* prod_{i} (x + gamma_i), only with few points */
+    std::vector<GF_element<F>> main_poly;
+    /* only with many points */
+    std::unique_ptr<Subproduct_tree<F>> tree;
+    Additive_FFT<F> fft;
+
+    void init_weights();
+
+public:
+    /* m points of the mode, m <= 2^n of the field */
+    Interpolation_plan(const int m, const Interpolation_mode mode);
+
+    /* the given distinct points */
+    explicit Interpolation_plan(const std::vector<GF_element<F>> &points);
+
+    const std::vector<GF_element<F>> &get_points() const
+    {
+        return this->points;
+    }
+
+    int size() const { return this->points.size(); }
+
+    /* the polynomial of degree < size() with the values at the points */
+    Polynomial<F> interpolate(const std::vector<GF_element<F>> &values) const;
+};
+
 namespace util
 {
-    Polynomial poly_interpolation(
-        const std::vector<GF_element> &gamma,
-        const std::vector<GF_element> &delta
+    template <typename F>
+    Polynomial<F> poly_interpolation(
+        const std::vector<GF_element<F>> &gamma,
+        const std::vector<GF_element<F>> &delta
+    );
+
+    /* quadratic, faster for few points */
+    template <typename F>
+    Polynomial<F> poly_interpolation_lagrange(
+        const std::vector<GF_element<F>> &gamma,
+        const std::vector<GF_element<F>> &delta
     );
 }
 
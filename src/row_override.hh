@@ -0,0 +1,84 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#ifndef ROW_OVERRIDE_H
+#define ROW_OVERRIDE_H
+
+#include <vector>
+#include <memory>
+
+#include "gf.hh"
+#include "fmatrix.hh"
+
+/* rows of a matrix saved before it is changed in place, shared by the
+ * views that still need them */
+template <typename F>
+struct Saved_rows
+{
+    /* index of each row in rows, -1 if the row is not saved */
+    std::vector<int> index;
+    /* the saved rows one after another */
+    std::vector<GF_element<F>> rows;
+};
+
+/* a matrix given by a shared base matrix and a multiple of its row i1
+ * added to each row, except that row i2 is replaced by its multiple.
+ * presents the M'' of EMatrix::row_op_per without copying the base,
+ * each view takes O(n) memory. the base may change in place if the
+ * rows it changes are saved to the view first */
+template <typename F>
+class Row_override
+{
+private:
+    std::shared_ptr<const FMatrix<F>> base;
+    int i1;
+    int i2;
+    /* multiple of row i1 for each row */
+    std::vector<GF_element<F>> t;
+    /* oldest first, the first one with a row has its value in the view */
+    std::vector<std::shared_ptr<const Saved_rows<F>>> saved;
+
+public:
+    /* t[i2] is the multiple that replaces row i2 */
+    Row_override(const std::shared_ptr<const FMatrix<F>> &base,
+                 const int i1,
+                 const int i2,
+                 const std::vector<GF_element<F>> &t):
+        base(base), i1(i1), i2(i2), t(t) {}
+
+    inline int get_n() const { return this->base->get_n(); }
+
+    /* the row of the base when the view was created */
+    inline const GF_element<F> *base_row(const int row) const
+    {
+        for (const std::shared_ptr<const Saved_rows<F>> &s : this->saved)
+            if (s->index[row] >= 0)
+                return &s->rows[s->index[row] * this->get_n()];
+        return &(*this->base)(row, 0);
+    }
+
+    /* call before the base changes the rows saved in s */
+    inline void save_rows(const std::shared_ptr<const Saved_rows<F>> &s)
+    {
+        this->saved.push_back(s);
+    }
+
+    inline int get_i1() const { return this->i1; }
+
+    inline int get_i2() const { return this->i2; }
+
+    inline const GF_element<F> &get_t(const int row) const
+    {
+        return this->t[row];
+    }
+
+    inline GF_element<F> operator()(const int row, const int col) const
+    {
+        const GF_element<F> &u = this->base_row(this->i1)[col];
+        if (row == this->i2)
+            return this->t[row] * u;
+        if (this->t[row] == util::GF_zero<F>())
+            return this->base_row(row)[col];
+        return this->base_row(row)[col] + this->t[row] * u;
+    }
+};
+
+#endif
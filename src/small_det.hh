@@ -0,0 +1,102 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#ifndef SMALL_DET_H
+#define SMALL_DET_H
+
+#include <immintrin.h>
+
+#include "gf.hh"
+#include "global.hh"
+#include "fmatrix.hh"
+#include "packed_fmatrix.hh"
+
+/* FMatrix::det uses small_det up to this size. only pdet_interpolation
+ * with SCALAR_DET calls it, the solver goes through cofactors */
+constexpr int SMALL_DET_MAX = 16;
+/* sizes computed by expansion without vectors or inversions */
+constexpr int SMALL_DET_EXPANSION = 4;
+
+/* determinant of an N x N matrix by expansion, N <= SMALL_DET_EXPANSION.
+ * signs do not matter in characteristic two */
+template <int N, typename F>
+GF_element<F> small_det_expansion(const FMatrix<F> &matrix)
+{
+    static_assert(N >= 2 && N <= SMALL_DET_EXPANSION);
+    if constexpr (N == 2)
+        return matrix(0, 0) * matrix(1, 1) + matrix(0, 1) * matrix(1, 0);
+    if constexpr (N == 3)
+        return matrix(0, 0) * (matrix(1, 1) * matrix(2, 2)
+                               + matrix(1, 2) * matrix(2, 1))
+            + matrix(0, 1) * (matrix(1, 0) * matrix(2, 2)
+                              + matrix(1, 2) * matrix(2, 0))
+            + matrix(0, 2) * (matrix(1, 0) * matrix(2, 1)
+                              + matrix(1, 1) * matrix(2, 0));
+    if constexpr (N == 4)
+    {
+        /* laplace expansion along rows 0 and 1 */
+        const auto minor = [&](const int r, const int c1, const int c2)
+        {
+            return matrix(r, c1) * matrix(r + 1, c2)
+                + matrix(r, c2) * matrix(r + 1, c1);
+        };
+        return minor(0, 0, 1) * minor(2, 2, 3)
+            + minor(0, 0, 2) * minor(2, 1, 3)
+            + minor(0, 0, 3) * minor(2, 1, 2)
+            + minor(0, 1, 2) * minor(2, 0, 3)
+            + minor(0, 1, 3) * minor(2, 0, 2)
+            + minor(0, 2, 3) * minor(2, 0, 1);
+    }
+}
+
+/* determinant of an N x N matrix with each row in vectors of VECTOR_N
+ * elements, N <= SMALL_DET_MAX. the bounds are constants, so the loops
+ * unroll and the rows stay in registers without allocations. W is one
+ * of the packed multiplications in packed_fmatrix.hh */
+template <int N, typename F, typename W>
+GF_element<F> small_det(const FMatrix<F> &matrix)
+{
+    if constexpr (N <= SMALL_DET_EXPANSION)
+        return small_det_expansion<N, F>(matrix);
+
+    constexpr int VECTOR_N = W::VECTOR_N;
+    /* vectors per row */
+    constexpr int V = (N + VECTOR_N - 1) / VECTOR_N;
+
+    long4_t a[N][V];
+    uint64_t elems[VECTOR_N];
+    for (int row = 0; row < N; row++)
+    {
+        for (int v = 0; v < V; v++)
+        {
+            /* padded columns are zero */
+            for (int i = 0; i < VECTOR_N; i++)
+                elems[i] = (VECTOR_N*v + i < N)
+                    ? matrix(row, VECTOR_N*v + i).get_repr() : 0x0;
+            a[row][v] = Lanes<W>::pack(elems);
+        }
+    }
+
+    return fraction_free_det<F, W>(&a[0][0], N, V);
+}
+
+/* small_det<N, F, W> for the n of the matrix, 2 <= n <= SMALL_DET_MAX */
+template <typename F, typename W, int N = 2>
+GF_element<F> dispatch_small_det(const FMatrix<F> &matrix)
+{
+    if constexpr (N < SMALL_DET_MAX)
+        if (matrix.get_n() != N)
+            return dispatch_small_det<F, W, N + 1>(matrix);
+    return small_det<N, F, W>(matrix);
+}
+
+/* small_det_expansion<N> for the n of the matrix,
+ * 2 <= n <= SMALL_DET_EXPANSION */
+template <typename F, int N = 2>
+GF_element<F> dispatch_small_det_expansion(const FMatrix<F> &matrix)
+{
+    if constexpr (N < SMALL_DET_EXPANSION)
+        if (matrix.get_n() != N)
+            return dispatch_small_det_expansion<F, N + 1>(matrix);
+    return small_det_expansion<N, F>(matrix);
+}
+
+#endif
@@ -1,6 +1,10 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <omp.h>
 
 #include "global.hh"
 #include "solver.hh"
@@ -10,43 +14,242 @@
 
 using namespace std;
 
+/* number of points the fingerprint is evaluated at in has_even_cycle */
+constexpr int DECISION_POINTS = 2;
+
+/* each cycle is contained in a single strongly connected component,
+ * so components can be solved independently. */
+template <typename F>
+vector<vector<int>> Solver<F>::cyclic_components(const Graph<F> &G) const
+{
+    vector<vector<int>> comps = G.strongly_connected_components();
+
+    /* cost of the algorithm is polynomial in size,
+     * so solve largest components first */
+    sort(comps.begin(), comps.end(),
+         [](const vector<int> &a, const vector<int> &b)
+         {
+             return a.size() > b.size();
+         });
+
+    /* single vertex has no cycles (ignoring loops, they are odd) */
+    while (!comps.empty() && comps.back().size() < 2)
+        comps.pop_back();
+
+    return comps;
+}
+
 /* returns the length of the shortest even cycle in G.
  * if no even cycle exists, returns -1 */
-int Solver::shortest_even_cycle(Graph &G) const
+template <typename F>
+int Solver<F>::shortest_even_cycle(Graph<F> &G) const
 {
-    vector<GF_element> gamma = util::distinct_elements(G.get_n() + 1);
-    vector<GF_element> delta(G.get_n() + 1);
+    const vector<vector<int>> comps = this->cyclic_components(G);
+    /* the largest component comes first */
+    if (!comps.empty()
+        && comps[0].size() + 1 > (1ull << F::get_n()))
+        return FIELD_TOO_SMALL;
+    const bool whole = comps.size() == 1 && (int) comps[0].size() == G.get_n();
+    vector<Graph<F>> graphs;
+    /* components of the same size share a plan */
+    vector<unique_ptr<Interpolation_plan<F>>> plans(G.get_n() + 2);
+
+    /* the random weights and points are drawn before any tasks, see
+     * global::randgen */
+    if (whole)
+        plans[G.get_n() + 1] = make_unique<Interpolation_plan<F>>(
+            G.get_n() + 1, this->mode);
 
-    #pragma omp parallel for
-    for (int l = 0; l <= G.get_n(); l++)
+    for (uint i = 0; !whole && i < comps.size(); i++)
+    {
+        graphs.push_back(G.induced_subgraph(comps[i]));
+        const int m = graphs[i].get_n() + 1;
+        if (!plans[m])
+            plans[m] = make_unique<Interpolation_plan<F>>(m, this->mode);
+    }
+
+    if (whole)
+        return this->fingerprint_shortest(G, *plans[G.get_n() + 1]);
+
+    vector<int> k(graphs.size());
+    /* inside a batch task the team exists already */
+    if (omp_in_parallel())
+    {
+        this->solve_components(graphs, plans, k);
+    }
+    else
+    {
+        #pragma omp parallel
+        #pragma omp single
+        this->solve_components(graphs, plans, k);
+    }
+
+    int len = -1;
+    for (uint i = 0; i < k.size(); i++)
+        if (k[i] != -1 && (len == -1 || k[i] < len))
+            len = k[i];
+
+    return len;
+}
+
+/* the components are tasks, and so are the evaluations and
+ * permanents inside them. idle threads take whichever is left */
+template <typename F>
+void Solver<F>::solve_components(
+    vector<Graph<F>> &graphs,
+    const vector<unique_ptr<Interpolation_plan<F>>> &plans,
+    vector<int> &k) const
+{
+    #pragma omp taskloop grainsize(1) shared(graphs, plans, k)
+    for (uint i = 0; i < graphs.size(); i++)
+        k[i] = this->fingerprint_shortest(
+            graphs[i],
+            *plans[graphs[i].get_n() + 1]
+        );
+}
+
+/* true if G has an even cycle */
+template <typename F>
+bool Solver<F>::has_even_cycle(Graph<F> &G) const
+{
+    /* the same random points do for every component. drawn before
+     * any tasks, see global::randgen */
+    const vector<GF_element<F>> gamma =
+        util::distinct_elements<F>(DECISION_POINTS);
+
+    const vector<vector<int>> comps = this->cyclic_components(G);
+    if (comps.size() == 1 && (int) comps[0].size() == G.get_n())
+        return this->fingerprint_decide(G, gamma);
+
+    vector<Graph<F>> graphs;
+    for (uint i = 0; i < comps.size(); i++)
+        graphs.push_back(G.induced_subgraph(comps[i]));
+
+    atomic<bool> found(false);
+    /* inside a batch task the team exists already */
+    if (omp_in_parallel())
+    {
+        this->decide_components(graphs, gamma, found);
+    }
+    else
+    {
+        #pragma omp parallel
+        #pragma omp single
+        this->decide_components(graphs, gamma, found);
+    }
+
+    return found;
+}
+
+/* the components are tasks like in solve_components. the ones that
+ * start after an even cycle is found are skipped */
+template <typename F>
+void Solver<F>::decide_components(vector<Graph<F>> &graphs,
+                                  const vector<GF_element<F>> &gamma,
+                                  atomic<bool> &found) const
+{
+    #pragma omp taskloop grainsize(1) shared(graphs, gamma, found)
+    for (uint i = 0; i < graphs.size(); i++)
+        if (!found.load(memory_order_relaxed)
+            && this->fingerprint_decide(graphs[i], gamma))
+            found.store(true, memory_order_relaxed);
+}
+
+/* the fingerprint at each gamma as a task. pcc spawns more tasks
+ * for the permanents in row_op_per, so the evaluations that take
+ * longer get help from the threads that are done */
+template <typename F>
+void Solver<F>::evaluate_fingerprint(Graph<F> &G,
+                                     const vector<GF_element<F>> &gamma,
+                                     vector<GF_element<F>> &delta) const
+{
+    const int points = gamma.size();
+    #pragma omp taskloop grainsize(1) shared(G, gamma, delta)
+    for (int l = 0; l < points; l++)
     {
         delta[l] = G.get_A().pcc(gamma[l]);
         if (global::output)
-            cout << l+1 << "/" << G.get_n()+1 << endl;
+        {
+            #pragma omp critical
+            cout << l+1 << "/" << points << endl;
+        }
+    }
+}
+
+/* the algorithm of Björklund, Husfeldt and Kaski on the whole G */
+template <typename F>
+int Solver<F>::fingerprint_shortest(Graph<F> &G,
+                                    const Interpolation_plan<F> &plan) const
+{
+    const vector<GF_element<F>> &gamma = plan.get_points();
+    vector<GF_element<F>> delta(G.get_n() + 1);
+
+    /* inside a component task the team exists already */
+    if (omp_in_parallel())
+    {
+        this->evaluate_fingerprint(G, gamma, delta);
+    }
+    else
+    {
+        #pragma omp parallel
+        #pragma omp single
+        this->evaluate_fingerprint(G, gamma, delta);
     }
 
-    const Polynomial p = util::poly_interpolation(gamma, delta);
+    const Polynomial<F> p = plan.interpolate(delta);
 
     for (int k = 2; k <= G.get_n(); k += 2)
-        if (p[G.get_n() - k] != util::GF_zero())
+        if (p[G.get_n() - k] != util::GF_zero<F>())
             return k;
 
     return -1;
 }
 
-/* brute force approach with DFS to find the
- * shortest even cycle in G. returns the length
- * of the shortest even cycle or -1 if no such
- * cycle exists */
-int Solver::shortest_even_cycle_brute(const Graph &G) const
+/* the fingerprint is a polynomial of degree at most n and it is non-zero
+ * iff G has an even cycle (w.h.p.). thus it is enough to evaluate it at
+ * random points, a non-zero polynomial vanishes at a random point with
+ * probability at most n / 2^d. */
+template <typename F>
+bool Solver<F>::fingerprint_decide(Graph<F> &G,
+                                   const vector<GF_element<F>> &gamma) const
 {
-    int len = G.get_n() + 1;
+    vector<GF_element<F>> delta(DECISION_POINTS);
 
-    for (int v = 0; v < G.get_n(); v++)
+    if (omp_in_parallel())
     {
-        vector<bool> visited(G.get_n(), false);
-        len = G.dfs_cycle(v, 1, v, visited, len);
+        this->evaluate_fingerprint(G, gamma, delta);
     }
+    else
+    {
+        #pragma omp parallel
+        #pragma omp single
+        this->evaluate_fingerprint(G, gamma, delta);
+    }
+
+    for (int l = 0; l < DECISION_POINTS; l++)
+        if (delta[l] != util::GF_zero<F>())
+            return true;
 
-    return (len == G.get_n() + 1) ? -1 : len;
+    return false;
 }
+
+/* brute force search of the shortest even cycle in G. each cycle is
+ * only searched from its smallest vertex, and the searches from
+ * different vertices run in parallel sharing the best length found.
+ * returns -1 if there are no even cycles */
+template <typename F>
+int Solver<F>::shortest_even_cycle_brute(const Graph<F> &G) const
+{
+    atomic<int> len(G.get_n() + 1);
+    const CSR radj = G.reverse();
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int v = 0; v < G.get_n(); v++)
+        G.even_cycle_search(v, radj, len);
+
+    return (len == G.get_n() + 1) ? -1 : len.load();
+}
+
+template class Solver<GF2_16>;
+template class Solver<GF2_32>;
+template class Solver<GF2_generic>;
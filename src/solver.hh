@@ -2,16 +2,70 @@
 #ifndef SOLVER_H
 #define SOLVER_H
 
+#include <vector>
+#include <memory>
+#include <atomic>
+
 #include "graph.hh"
+#include "polynomial.hh"
+
+/* shortest_even_cycle returns this if a component has more vertices
+ * than there are distinct evaluation points in the field */
+constexpr int FIELD_TOO_SMALL = -2;
 
+/* the solver over the field F, see GF_element */
+template <typename F>
 class Solver
 {
+private:
+    /* evaluation points of the fingerprint */
+    Interpolation_mode mode;
+
+    /* vertex sets of the strongly connected components of G
+     * that can contain cycles, sorted by decreasing size */
+    std::vector<std::vector<int>> cyclic_components(const Graph<F> &G) const;
+
+    /* fingerprint_shortest of each graph to k. has to be called
+     * by one thread of a parallel region */
+    void solve_components(
+        std::vector<Graph<F>> &graphs,
+        const std::vector<std::unique_ptr<Interpolation_plan<F>>> &plans,
+        std::vector<int> &k) const;
+
+    /* pcc at each gamma to delta. has to be called by
+     * one thread of a parallel region */
+    void evaluate_fingerprint(Graph<F> &G,
+                              const std::vector<GF_element<F>> &gamma,
+                              std::vector<GF_element<F>> &delta) const;
+
+    /* plan has the G.get_n() + 1 evaluation points */
+    int fingerprint_shortest(Graph<F> &G,
+                             const Interpolation_plan<F> &plan) const;
+
+    /* fingerprint_decide of each graph, found is set if one has an
+     * even cycle. has to be called by one thread of a parallel region */
+    void decide_components(std::vector<Graph<F>> &graphs,
+                           const std::vector<GF_element<F>> &gamma,
+                           std::atomic<bool> &found) const;
+
+    /* the fingerprint at the DECISION_POINTS random points gamma */
+    bool fingerprint_decide(Graph<F> &G,
+                            const std::vector<GF_element<F>> &gamma) const;
+
 public:
-    Solver() {}
+    explicit Solver(const Interpolation_mode mode = SUBSPACE_POINTS):
+        mode(mode) {}
+
+    /* -1 if there is no even cycle, FIELD_TOO_SMALL if a component
+     * of c vertices needs more than the 2^n elements of the field
+     * for its c + 1 points */
+    int shortest_even_cycle(Graph<F> &G) const;
 
-    int shortest_even_cycle(Graph &G) const;
+    /* true if G has an even cycle. cheaper than the above
+     * as the fingerprint is not interpolated */
+    bool has_even_cycle(Graph<F> &G) const;
 
-    int shortest_even_cycle_brute(const Graph &G) const;
+    int shortest_even_cycle_brute(const Graph<F> &G) const;
 };
 
 #endif
@@ -12,33 +12,58 @@ using namespace std;
 
 namespace util
 {
-    void direct_undirected(std::vector<std::vector<int>> &adj)
+    CSR direct_undirected(const CSR &adj)
     {
-        for (int u = 0; u < (int) adj.size(); u++)
+        const int n = adj.get_n();
+
+        /* neighbours of each vertex sorted, with the arc indices,
+         * for finding the reverse arc */
+        std::vector<std::pair<int,int>> sorted(adj.get_m());
+        for (int i = 0; i < adj.get_m(); i++)
+            sorted[i] = { adj.targets[i], i };
+        for (int v = 0; v < n; v++)
+            std::sort(sorted.begin() + adj.offsets[v],
+                      sorted.begin() + adj.offsets[v + 1]);
+
+        /* each edge {u,v} with u < v is decided at the arc u->v,
+         * the arc is kept if the bit is zero and reversed otherwise */
+        std::vector<bool> flip(adj.get_m());
+        for (int u = 0; u < n; u++)
+            for (int i = adj.offsets[u]; i < adj.offsets[u + 1]; i++)
+                if (u < adj.targets[i])
+                    flip[i] = global::randgen() % 2;
+
+        CSR directed;
+        directed.offsets.resize(n + 1);
+        directed.targets.reserve(adj.get_m() / 2);
+        for (int u = 0; u < n; u++)
         {
-            std::vector<int> nbors = adj[u];
-            for (int i = 0; i < (int) nbors.size(); i++)
+            for (int i = adj.offsets[u]; i < adj.offsets[u + 1]; i++)
             {
-                const int v = nbors[i];
-                if (u > v)
-                    continue;
-                /* rndom choose del */
-                int keep = u;
-                int del = v;
-                if (global::randgen() % 2)
+                const int v = adj.targets[i];
+                bool keep;
+                if (u < v)
                 {
-                    keep = v;
-                    del = u;
+                    keep = !flip[i];
                 }
-                std::vector<int>::iterator pos = std::find(
-                    adj[del].begin(),
-                    adj[del].end(),
-                    keep
-                );
-                adj[del].erase(pos);
+                else
+                {
+                    /* the arc v->u decides */
+                    const auto pos = std::lower_bound(
+                        sorted.begin() + adj.offsets[v],
+                        sorted.begin() + adj.offsets[v + 1],
+                        std::make_pair(u, 0)
+                    );
+                    keep = pos == sorted.begin() + adj.offsets[v + 1]
+                        || pos->first != u || flip[pos->second];
+                }
+                if (keep)
+                    directed.targets.push_back(v);
             }
+            directed.offsets[u + 1] = directed.targets.size();
         }
-        return;
+
+        return directed;
     }
 
     /* Ben-Or's irreducible polynomial generator.
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "global.hh"
+#include "csr.hh"
 
 namespace util
 {
@@ -15,10 +16,10 @@ namespace util
         return 63 - __builtin_clzl(a);
     }
 
-    /* given an adjacency list for an undirected graph,
+    /* given an undirected graph, ie. both u->v and v->u are arcs,
      * directs it such that edges are made one way
      * with direction chosen uniformly at random. */
-    void direct_undirected(std::vector<std::vector<int>> &adj);
+    CSR direct_undirected(const CSR &adj);
 
     uint64_t irred_poly(const int deg);
     bool gcd1(const int i, const std::bitset<64> &p);
@@ -13,10 +13,11 @@ constexpr uint64_t WARMUP = 1 << 15;
 
 enum Mul_enum { REF_MUL, FAST_MUL, KRONECKER_MUL };
 enum Rem_enum { EUCLID_REM, INTEL_REM, MONT_REM };
+enum Backend_enum { VIRTUAL_BACKEND, INLINE_BACKEND };
 
 using namespace std;
 
-util::rand64bit global::randgen;
+thread_local util::rand64bit global::randgen;
 GR4_n *global::E;
 GF2_n *global::F;
 bool global::output = false;
@@ -114,6 +115,121 @@ double bench_rem(
     return end - start;
 }
 
+/* the rings before GR4<N, MOD>: kronecker_mul and intel_rem were
+ * virtual and overridden for n = 16 and n = 32. kept here as the
+ * baseline of the compiled rings */
+class Virtual_GR4_n : public GR4_n
+{
+public:
+    using GR4_n::GR4_n;
+
+    virtual ~Virtual_GR4_n() { }
+
+    virtual GR_repr kronecker_mul(const GR_repr &a, const GR_repr &b) const
+    {
+        return this->GR4_n::kronecker_mul(a, b);
+    }
+
+    virtual GR_repr intel_rem(const GR_repr &a) const
+    {
+        return this->GR4_n::intel_rem(a);
+    }
+};
+
+class Virtual_GR4_16 : public Virtual_GR4_n
+{
+public:
+    using Virtual_GR4_n::Virtual_GR4_n;
+
+    GR_repr kronecker_mul(const GR_repr &a, const GR_repr &b) const override
+    {
+        return kronecker::mul_16(a, b);
+    }
+
+    GR_repr intel_rem(const GR_repr &a) const override
+    {
+        const GR_repr hi = a >> 16;
+        const GR_repr lo = a & 0xFFFF;
+
+        GR_repr tmp = hi >> 14;
+        tmp = this->add(tmp, hi >> 13);
+        tmp = this->add(tmp, hi >> 11);
+        tmp = this->subtract(hi, tmp);
+
+        GR_repr r = this->add(tmp, tmp << 2);
+        r = this->add(r, tmp << 3);
+        r = this->add(r, tmp << 5);
+
+        r &= 0xFFFF;
+        return this->subtract(lo, r);
+    }
+};
+
+class Virtual_GR4_32 : public Virtual_GR4_n
+{
+public:
+    using Virtual_GR4_n::Virtual_GR4_n;
+
+    GR_repr intel_rem(const GR_repr &a) const override
+    {
+        const GR_repr hi = a >> 32;
+        const GR_repr lo = a & 0xFFFFFFFF;
+
+        GR_repr tmp = hi >> 30;
+        tmp = this->add(tmp, hi >> 29);
+        tmp = this->add(tmp, hi >> 25);
+        tmp = this->subtract(hi, tmp);
+
+        GR_repr r = this->add(tmp, tmp << 2);
+        r = this->add(r, tmp << 3);
+        r = this->add(r, tmp << 7);
+
+        r &= 0xFFFFFFFF;
+        return this->subtract(lo, r);
+    }
+};
+
+/* whole multiplication with reduction, either through the virtual
+ * kronecker_mul and intel_rem of V or the mul and rem of the ring R */
+template <typename R, Backend_enum B>
+double bench_backend(
+    const Virtual_GR4_n *V,
+    vector<GR_repr> a,
+    vector<GR_repr> b,
+    uint64_t t)
+{
+    GR_repr w = {0, 0};
+
+    uint64_t wup = (WARMUP > t) ? t : WARMUP;
+    #pragma omp parallel for
+    for (uint64_t i = 0; i < wup; i++)
+        w = global::E->add(w, global::E->rem(global::E->mul(a[i], b[i])));
+
+    double start = omp_get_wtime();
+    #pragma omp parallel for
+    for (uint64_t i = 0; i < t; i++)
+    {
+        switch (B)
+        {
+        case VIRTUAL_BACKEND:
+            a[i] = V->intel_rem(V->kronecker_mul(a[i], b[i]));
+            break;
+        case INLINE_BACKEND:
+            a[i] = R::rem(R::mul(a[i], b[i]));
+            break;
+        }
+    }
+    double end = omp_get_wtime();
+
+    if (start > end)
+    {
+        cout << a[time(nullptr) % t].hi << a[time(nullptr) % t].lo << endl;
+        cout << w.hi << w.lo << endl;
+    }
+
+    return end - start;
+}
+
 int main(int argc, char **argv)
 {
     if (argc == 1)
@@ -150,29 +266,34 @@ int main(int argc, char **argv)
     }
 
     cout << "seed: " << seed << endl;
-    global::randgen.init(seed);
+    global::randgen.init_all(seed);
 
     omp_set_num_threads(p);
 
     uint64_t mod;
+    /* the baseline of the compiled rings */
+    const Virtual_GR4_n *V;
     switch (n)
     {
     case 16:
         /* x^16 + x^5 + x^3 + x^2 +  1 */
-        mod = 0x1002D;
-        global::F = new GF2_16(16, mod);
-        global::E = new GR4_16(16, mod);
+        mod = GF2_16::get_mod();
+        global::F = new GF2_n(16, mod);
+        global::E = new GR4_n(16, mod);
+        V = new Virtual_GR4_16(16, mod);
         break;
     case 32:
         /* x^32 + x^7 + x^3 + x^2 + 1 */
-        mod = 0x10000008D;
-        global::F = new GF2_32(32, mod);
-        global::E = new GR4_32(32, mod);
+        mod = GF2_32::get_mod();
+        global::F = new GF2_n(32, mod);
+        global::E = new GR4_n(32, mod);
+        V = new Virtual_GR4_32(32, mod);
         break;
     default:
         mod = util::irred_poly(n);
         global::F = new GF2_n(n, mod);
         global::E = new GR4_n(n, mod);
+        V = new Virtual_GR4_n(n, mod);
         break;
     }
     vector<GR_repr> a(t);
@@ -261,5 +382,38 @@ int main(int argc, char **argv)
 
     cout << endl;
 
+    double virt;
+    switch (n)
+    {
+    case 16:
+        virt = bench_backend<GR4_16, VIRTUAL_BACKEND>(V, a, b, t);
+        delta = bench_backend<GR4_16, INLINE_BACKEND>(V, a, b, t);
+        break;
+    case 32:
+        virt = bench_backend<GR4_32, VIRTUAL_BACKEND>(V, a, b, t);
+        delta = bench_backend<GR4_32, INLINE_BACKEND>(V, a, b, t);
+        break;
+    default:
+        virt = bench_backend<GR4_generic, VIRTUAL_BACKEND>(V, a, b, t);
+        delta = bench_backend<GR4_generic, INLINE_BACKEND>(V, a, b, t);
+        break;
+    }
+
+    mhz = t / virt;
+    mhz /= 1e6;
+
+    cout << t << " virtual mul + rem in time: " <<
+        virt << " s or " << mhz << " Mhz" << endl;
+
+    mhz = t / delta;
+    mhz /= 1e6;
+
+    cout << t << " compiled mul + rem in time: " <<
+        delta << " s or " << mhz << " Mhz" << endl;
+
+    cout << "speedup: " << virt / delta << endl;
+
+    cout << endl;
+
     return 0;
 }
@@ -0,0 +1,349 @@
+/* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <getopt.h>
+#include <omp.h>
+
+#include "../../src/global.hh"
+#include "../../src/gf.hh"
+#include "../../src/extension.hh"
+#include "../../src/fmatrix.hh"
+#include "../../src/packed_fmatrix.hh"
+#include "../../src/lane_fmatrix.hh"
+
+using namespace std;
+
+thread_local util::rand64bit global::randgen;
+GF2_n *global::F;
+GR4_n *global::E;
+bool global::output = false;
+
+template <typename F>
+double bench_pdet(const vector<FMatrix<F>> &matrices,
+                  const Det_engine engine,
+                  const Interpolation_mode mode = SUBSPACE_POINTS)
+{
+    const int n = matrices[0].get_n();
+    GF_element<F> w = util::GF_zero<F>();
+
+    double start = omp_get_wtime();
+    /* one plan for all of the matrices */
+    const Interpolation_plan<F> plan(2*n - 1, mode);
+    for (uint64_t i = 0; i < matrices.size(); i++)
+    {
+        Polynomial<F> p =
+            matrices[i].pdet_interpolation(0, n - 1, plan, engine);
+        w += p[n - 1];
+    }
+    double end = omp_get_wtime();
+
+    if (start > end)
+        cout << w.get_repr() << endl;
+
+    return end - start;
+}
+
+/* determinants of copies of the matrices with FMatrix::det, which is
+ * small_det for small matrices, or with the plain elimination */
+template <typename F>
+double bench_det(const vector<FMatrix<F>> &matrices, const bool elimination)
+{
+    const int n = matrices[0].get_n();
+    GF_element<F> w = util::GF_zero<F>();
+
+    double start = omp_get_wtime();
+    for (uint64_t i = 0; i < matrices.size(); i++)
+    {
+        FMatrix<F> A(n);
+        A.copy(matrices[i]);
+        w += (elimination) ? A.det_elimination() : A.det();
+    }
+    double end = omp_get_wtime();
+
+    if (start > end)
+        cout << w.get_repr() << endl;
+
+    return end - start;
+}
+
+/* determinants of the packed matrices with the inversion of each
+ * pivot or with the fraction free elimination */
+template <typename F, typename W>
+double bench_packed_det(const vector<FMatrix<F>> &matrices,
+                        const bool fraction_free)
+{
+    const int n = matrices[0].get_n();
+    GF_element<F> w = util::GF_zero<F>();
+
+    double start = omp_get_wtime();
+    for (uint64_t i = 0; i < matrices.size(); i++)
+    {
+        Packed_FMatrix<F, W> PA(n, matrices[i]);
+        PA.init();
+        w += (fraction_free) ? PA.det_fraction_free() : PA.det();
+    }
+    double end = omp_get_wtime();
+
+    if (start > end)
+        cout << w.get_repr() << endl;
+
+    return end - start;
+}
+
+template <typename F>
+double bench_packed_det(const vector<FMatrix<F>> &matrices,
+                        const bool fraction_free)
+{
+    if constexpr (is_same_v<F, GF2_16>)
+        return bench_packed_det<F, Wide_16>(matrices, fraction_free);
+    else if constexpr (is_same_v<F, GF2_32>)
+        return bench_packed_det<F, Wide_32>(matrices, fraction_free);
+    else if (F::get_n() < 16)
+        return bench_packed_det<F, Wide_n>(matrices, fraction_free);
+    else
+        return bench_packed_det<F, Wide_n_64>(matrices, fraction_free);
+}
+
+/* low sums of the matrices with rows 0 and n - 1 similar, one by one
+ * or in the lanes of Lane_FMatrix */
+template <typename F, typename W>
+double bench_low_sum(const vector<FMatrix<F>> &matrices, const bool lanes)
+{
+    constexpr int LANES = Lane_FMatrix<F, W>::lanes();
+    const int n = matrices[0].get_n();
+    const vector<pair<int, int>> rows(matrices.size(), make_pair(0, n - 1));
+    GF_element<F> w = util::GF_zero<F>();
+
+    double start = omp_get_wtime();
+    if (lanes)
+    {
+        for (uint64_t i = 0; i < matrices.size(); i += LANES)
+        {
+            GF_element<F> sums[LANES];
+            Lane_FMatrix<F, W> L(matrices, rows, i);
+            L.pdet_low_sums(sums);
+            w += sums[0];
+        }
+    }
+    else
+    {
+        for (uint64_t i = 0; i < matrices.size(); i++)
+            w += matrices[i].pdet_low_sum(0, n - 1);
+    }
+    double end = omp_get_wtime();
+
+    if (start > end)
+        cout << w.get_repr() << endl;
+
+    return end - start;
+}
+
+template <typename F>
+double bench_low_sum(const vector<FMatrix<F>> &matrices, const bool lanes)
+{
+    if constexpr (is_same_v<F, GF2_16>)
+        return bench_low_sum<F, Wide_16>(matrices, lanes);
+    else if constexpr (is_same_v<F, GF2_32>)
+        return bench_low_sum<F, Wide_32>(matrices, lanes);
+    else if (F::get_n() < 16)
+        return bench_low_sum<F, Wide_n>(matrices, lanes);
+    else
+        return bench_low_sum<F, Wide_n_64>(matrices, lanes);
+}
+
+enum Interpolation_kind {
+    LAGRANGE,
+    SUBPRODUCT_TREE,
+    LAGRANGE_PLAN,
+    ADDITIVE_FFT_PLAN
+};
+
+/* t interpolations through m points. the plans are made once */
+template <typename F>
+double bench_interpolation(const int m,
+                           const uint64_t t,
+                           const Interpolation_kind kind)
+{
+    const Interpolation_plan<F> plan(m, (kind == ADDITIVE_FFT_PLAN) ?
+                                     SUBSPACE_POINTS : RANDOM_POINTS);
+    const vector<GF_element<F>> &gamma = plan.get_points();
+    vector<GF_element<F>> delta(m);
+    for (int i = 0; i < m; i++)
+        delta[i] = util::GF_random<F>();
+    GF_element<F> w = util::GF_zero<F>();
+
+    double start = omp_get_wtime();
+    for (uint64_t i = 0; i < t; i++)
+    {
+        delta[i % m] += w;
+        switch (kind)
+        {
+        case LAGRANGE:
+            w += util::poly_interpolation_lagrange(gamma, delta)[m - 1];
+            break;
+        case SUBPRODUCT_TREE:
+            w += Subproduct_tree<F>(gamma).interpolate(delta)[m - 1];
+            break;
+        case LAGRANGE_PLAN:
+        case ADDITIVE_FFT_PLAN:
+            w += plan.interpolate(delta)[m - 1];
+            break;
+        }
+    }
+    double end = omp_get_wtime();
+
+    if (start > end)
+        cout << w.get_repr() << endl;
+
+    return end - start;
+}
+
+/* the benchmarks over the field F, the fields are set in main */
+template <typename F>
+void bench(const uint64_t t, const int dim)
+{
+    vector<FMatrix<F>> matrices(t, FMatrix<F>(dim));
+    for (uint64_t i = 0; i < t; i++)
+        for (int row = 0; row < dim; row++)
+            for (int col = 0; col < dim; col++)
+                matrices[i].set(row, col, util::GF_random<F>());
+
+    double delta;
+
+    delta = bench_det(matrices, true);
+    cout << t << " dets of dimension " << dim << " with elimination in time: "
+        << delta << " s" << endl;
+
+    delta = bench_det(matrices, false);
+    cout << t << " dets of dimension " << dim << " with det in time: "
+        << delta << " s" << endl;
+
+    delta = bench_packed_det(matrices, false);
+    cout << t << " packed dets of dimension " << dim << " in time: "
+        << delta << " s" << endl;
+
+    delta = bench_packed_det(matrices, true);
+    cout << t << " packed dets of dimension " << dim
+        << " with fraction free elimination in time: " << delta << " s" << endl;
+
+    delta = bench_pdet(matrices, SCALAR_DET);
+    cout << t << " pdets of dimension " << dim << " with scalar det in time: "
+        << delta << " s" << endl;
+
+    delta = bench_pdet(matrices, PACKED_DET);
+    cout << t << " pdets of dimension " << dim << " with packed det in time: "
+        << delta << " s" << endl;
+
+    delta = bench_pdet(matrices, BATCHED_DET);
+    cout << t << " pdets of dimension " << dim << " with batched det in time: "
+        << delta << " s" << endl;
+
+    delta = bench_pdet(matrices, BATCHED_DET, RANDOM_POINTS);
+    cout << t << " pdets of dimension " << dim
+        << " with batched det at random points in time: "
+        << delta << " s" << endl;
+
+    delta = bench_low_sum(matrices, false);
+    cout << t << " low sums of dimension " << dim << " in time: "
+        << delta << " s" << endl;
+
+    delta = bench_low_sum(matrices, true);
+    cout << t << " low sums of dimension " << dim << " in lanes in time: "
+        << delta << " s" << endl;
+
+    /* the interpolations alone, pdet has 2*dim - 1 points */
+    const int m = 2*dim - 1;
+    delta = bench_interpolation<F>(m, t, LAGRANGE);
+    cout << t << " lagrange interpolations of " << m << " points in time: "
+        << delta << " s" << endl;
+
+    delta = bench_interpolation<F>(m, t, SUBPRODUCT_TREE);
+    cout << t << " subproduct tree interpolations of " << m
+        << " points in time: " << delta << " s" << endl;
+
+    delta = bench_interpolation<F>(m, t, LAGRANGE_PLAN);
+    cout << t << " lagrange interpolations of " << m
+        << " points with a plan in time: " << delta << " s" << endl;
+
+    delta = bench_interpolation<F>(m, t, ADDITIVE_FFT_PLAN);
+    cout << t << " additive fft interpolations of " << m
+        << " points with a plan in time: " << delta << " s" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 1)
+    {
+        cout << "-s $int for seed" << endl;
+        cout << "-t $int for amount of polynomial determinants" << endl;
+        cout << "-n $int for size of finite field" << endl;
+        cout << "-d $int for dimension of the matrices" << endl;
+        return 0;
+    }
+    uint64_t seed = time(nullptr);
+
+    uint64_t t = 1;
+    int n = 16;
+    int dim = 20;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:t:n:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            n = stoi(optarg);
+            break;
+        case 's':
+            seed = stoi(optarg);
+            break;
+        case 't':
+            t = stoi(optarg);
+            break;
+        case 'd':
+            dim = stoi(optarg);
+            break;
+        }
+    }
+
+    cout << "seed: " << seed << endl;
+    global::randgen.init_all(seed);
+
+    uint64_t mod;
+    switch (n)
+    {
+    case 16:
+        /* x^16 + x^5 + x^3 + x^2 +  1 */
+        mod = GF2_16::get_mod();
+        global::F = new GF2_n(16, mod);
+        global::E = new GR4_n(16, mod);
+        break;
+    case 32:
+        /* x^32 + x^7 + x^3 + x^2 + 1 */
+        mod = GF2_32::get_mod();
+        global::F = new GF2_n(32, mod);
+        global::E = new GR4_n(32, mod);
+        break;
+    default:
+        mod = util::irred_poly(n);
+        global::F = new GF2_n(n, mod);
+        global::E = new GR4_n(n, mod);
+        break;
+    }
+
+    switch (n)
+    {
+    case 16:
+        bench<GF2_16>(t, dim);
+        break;
+    case 32:
+        bench<GF2_32>(t, dim);
+        break;
+    default:
+        bench<GF2_generic>(t, dim);
+        break;
+    }
+
+    return 0;
+}
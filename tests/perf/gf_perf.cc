@@ -2,93 +2,84 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <string>
 #include <getopt.h>
 #include <omp.h>
 
 #include "../../src/global.hh"
 #include "../../src/gf.hh"
 #include "../../src/extension.hh"
-
-typedef long long int long4_t __attribute__ ((vector_size (32)));
+#include "../../src/packed_fmatrix.hh"
 
 constexpr int VECTOR_N = 8;
+constexpr int VECTOR_N_64 = 4;
 
 using namespace std;
 
-util::rand64bit global::randgen;
+thread_local util::rand64bit global::randgen;
 GF2_n *global::F;
 GR4_n *global::E;
 bool global::output = false;
 
-int main(int argc, char **argv)
+/* squares with mul and sqr of W, and inversions of the lanes with
+ * batch_inverse and itoh_tsujii */
+template <typename W>
+void bench_wide(const vector<long4_t> &av,
+                vector<long4_t> &pv,
+                const string &name)
 {
-    if (argc == 1)
-    {
-        cout << "-s $int for seed" << endl;
-        cout << "-t $int for amount of tests" << endl;
-        cout << "-n $int for size of finite field" << endl;
-        return 0;
-    }
-    uint64_t seed = time(nullptr);
+    const uint64_t t = av.size();
+    const uint64_t elems = W::VECTOR_N*t;
+    double start;
+    double delta;
 
-    uint64_t t = 1;
-    int n = 16;
-    int opt;
-    while ((opt = getopt(argc, argv, "s:t:n:")) != -1)
-    {
-        switch (opt)
-        {
-        case 'n':
-            n = stoi(optarg);
-            break;
-        case 's':
-            seed = stoi(optarg);
-            break;
-        case 't':
-            t = stoi(optarg);
-            break;
-        }
-    }
+    start = omp_get_wtime();
+    for (uint64_t i = 0; i < t; i++)
+        pv[i] = W::mul(av[i], av[i]);
+    delta = omp_get_wtime() - start;
+    cout << elems << " squares with " << name << " mul in time: " <<
+        delta << " s or " << elems / delta / 1e6 << " Mhz" << endl;
 
-    cout << "seed: " << seed << endl;
-    global::randgen.init(seed);
+    start = omp_get_wtime();
+    for (uint64_t i = 0; i < t; i++)
+        pv[i] = W::sqr(av[i]);
+    delta = omp_get_wtime() - start;
+    cout << elems << " squares with " << name << " sqr in time: " <<
+        delta << " s or " << elems / delta / 1e6 << " Mhz" << endl;
 
-    uint64_t mod;
-    switch (n)
-    {
-    case 16:
-        /* x^16 + x^5 + x^3 + x^2 +  1 */
-        mod = 0x1002D;
-        global::F = new GF2_16(16, mod);
-        global::E = new GR4_16(16, mod);
-        break;
-    case 32:
-        /* x^32 + x^7 + x^3 + x^2 + 1 */
-        mod = 0x10000008D;
-        global::F = new GF2_32(32, mod);
-        global::E = new GR4_32(32, mod);
-        break;
-    default:
-        mod = util::irred_poly(n);
-        global::F = new GF2_n(n, mod);
-        global::E = new GR4_n(n, mod);
-        break;
-    }
+    start = omp_get_wtime();
+    for (uint64_t i = 0; i < t; i++)
+        pv[i] = Lanes<W>::batch_inverse(av[i]);
+    delta = omp_get_wtime() - start;
+    cout << elems << " inversions with " << name << " batch inverse in time: " <<
+        delta << " s or " << elems / delta / 1e6 << " Mhz" << endl;
+
+    start = omp_get_wtime();
+    for (uint64_t i = 0; i < t; i++)
+        pv[i] = Lanes<W>::itoh_tsujii(av[i]);
+    delta = omp_get_wtime() - start;
+    cout << elems << " inversions with " << name << " itoh-tsujii in time: " <<
+        delta << " s or " << elems / delta / 1e6 << " Mhz" << endl;
+}
 
+/* the scalar operations of the field F */
+template <typename F>
+void bench_scalar(const uint64_t t)
+{
     vector<uint64_t> a(t);
     vector<uint64_t> b(t);
     vector<uint64_t> p(t);
     vector<uint64_t> r(t);
 
-    vector<GF_element> aa(t);
-    vector<GF_element> bb(t);
+    vector<GF_element<F>> aa(t);
+    vector<GF_element<F>> bb(t);
 
     for (uint64_t i = 0; i < t; i++)
     {
-        a[i] = global::randgen() & global::F->get_mask();
-        b[i] = global::randgen() & global::F->get_mask();
-        aa[i] = util::GF_random();
-        bb[i] = util::GF_random();
+        a[i] = global::randgen() & F::get_mask();
+        b[i] = global::randgen() & F::get_mask();
+        aa[i] = util::GF_random<F>();
+        bb[i] = util::GF_random<F>();
     }
 
     double start;
@@ -109,7 +100,7 @@ int main(int argc, char **argv)
 
     start = omp_get_wtime();
     for (uint64_t i = 0; i < t; i++)
-        p[i] = global::F->clmul(a[i], b[i]);
+        p[i] = F::clmul(a[i], b[i]);
     end = omp_get_wtime();
     delta = (end - start);
     mhz = t / delta;
@@ -120,7 +111,7 @@ int main(int argc, char **argv)
 
     start = omp_get_wtime();
     for (uint64_t i = 0; i < t; i++)
-        r[i] = global::F->rem(p[i]);
+        r[i] = F::rem(p[i]);
     end = omp_get_wtime();
     delta = (end - start);
     mhz = t / delta;
@@ -129,9 +120,26 @@ int main(int argc, char **argv)
     cout << t << " remainder in time: " <<
         delta << " s or " << mhz << " Mhz" << endl;
 
+    /* the reduction of GF2_n reads the modulus of the field */
     start = omp_get_wtime();
     for (uint64_t i = 0; i < t; i++)
-        r[i] = global::F->ext_euclid(r[i]);
+        r[i] = global::F->rem(p[i]);
+    end = omp_get_wtime();
+    delta = (end - start);
+    mhz = t / delta;
+    mhz /= 1e6;
+
+    cout << t << " remainder with GF2_n in time: " <<
+        delta << " s or " << mhz << " Mhz" << endl;
+
+    /* ext_euclid does not terminate on zero */
+    for (uint64_t i = 0; i < t; i++)
+        if (r[i] == 0)
+            r[i] = 1;
+
+    start = omp_get_wtime();
+    for (uint64_t i = 0; i < t; i++)
+        r[i] = F::ext_euclid(r[i]);
     end = omp_get_wtime();
     delta = (end - start);
     mhz = t / delta;
@@ -140,39 +148,205 @@ int main(int argc, char **argv)
     cout << t << " inversion in time: " <<
         delta << " s or " << mhz << " Mhz" << endl;
 
+    start = omp_get_wtime();
+    util::batch_inverse(bb);
+    end = omp_get_wtime();
+    delta = (end - start);
+    mhz = t / delta;
+    mhz /= 1e6;
+
+    cout << t << " inversion in one batch in time: " <<
+        delta << " s or " << mhz << " Mhz" << endl;
+
+    start = omp_get_wtime();
+    for (uint64_t i = 0; i < t; i++)
+        r[i] = global::F->itoh_tsujii(a[i]);
+    end = omp_get_wtime();
+    delta = (end - start);
+    mhz = t / delta;
+    mhz /= 1e6;
+
+    cout << t << " itoh-tsujii inversion in time: " <<
+        delta << " s or " << mhz << " Mhz" << endl;
 
-    if (global::F->get_n() != 16)
+    start = omp_get_wtime();
+    for (uint64_t i = 0; i < t; i++)
+        p[i] = F::rem(F::clmul(a[i], a[i]));
+    end = omp_get_wtime();
+    delta = (end - start);
+    mhz = t / delta;
+    mhz /= 1e6;
+
+    cout << t << " squares with mul in time: " <<
+        delta << " s or " << mhz << " Mhz" << endl;
+
+    start = omp_get_wtime();
+    for (uint64_t i = 0; i < t; i++)
+        p[i] = F::sqr(a[i]);
+    end = omp_get_wtime();
+    delta = (end - start);
+    mhz = t / delta;
+    mhz /= 1e6;
+
+    cout << t << " squares with pdep in time: " <<
+        delta << " s or " << mhz << " Mhz" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 1)
+    {
+        cout << "-s $int for seed" << endl;
+        cout << "-t $int for amount of tests" << endl;
+        cout << "-n $int for size of finite field" << endl;
         return 0;
+    }
+    uint64_t seed = time(nullptr);
+
+    uint64_t t = 1;
+    int n = 16;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:t:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            n = stoi(optarg);
+            break;
+        case 's':
+            seed = stoi(optarg);
+            break;
+        case 't':
+            t = stoi(optarg);
+            break;
+        }
+    }
+
+    cout << "seed: " << seed << endl;
+    global::randgen.init_all(seed);
 
+    uint64_t mod;
+    switch (n)
+    {
+    case 16:
+        /* x^16 + x^5 + x^3 + x^2 +  1 */
+        mod = GF2_16::get_mod();
+        global::F = new GF2_n(16, mod);
+        global::E = new GR4_n(16, mod);
+        break;
+    case 32:
+        /* x^32 + x^7 + x^3 + x^2 + 1 */
+        mod = GF2_32::get_mod();
+        global::F = new GF2_n(32, mod);
+        global::E = new GR4_n(32, mod);
+        break;
+    default:
+        mod = util::irred_poly(n);
+        global::F = new GF2_n(n, mod);
+        global::E = new GR4_n(n, mod);
+        break;
+    }
+
+    switch (n)
+    {
+    case 16:
+        bench_scalar<GF2_16>(t);
+        break;
+    case 32:
+        bench_scalar<GF2_32>(t);
+        break;
+    default:
+        bench_scalar<GF2_generic>(t);
+        break;
+    }
+
+    double start;
+    double end;
+    double delta;
+    double mhz;
+
+    /* elements in the low halves of 64-bit lanes fit all the kernels */
+    const uint64_t mask = global::F->get_mask();
     vector<long4_t> av(t);
     vector<long4_t> bv(t);
     vector<long4_t> pv(t);
     for (uint64_t i = 0; i < t; i++)
     {
         av[i] = _mm256_set_epi64x(
-            global::randgen(),
-            global::randgen(),
-            global::randgen(),
-            global::randgen()
+            global::randgen() & mask,
+            global::randgen() & mask,
+            global::randgen() & mask,
+            global::randgen() & mask
         );
         bv[i] = _mm256_set_epi64x(
-            global::randgen(),
-            global::randgen(),
-            global::randgen(),
-            global::randgen()
+            global::randgen() & mask,
+            global::randgen() & mask,
+            global::randgen() & mask,
+            global::randgen() & mask
         );
     }
 
+    if (global::F->get_n() == 16)
+    {
+        start = omp_get_wtime();
+        for (uint64_t i = 0; i < t; i++)
+            pv[i] = global::F->wide_mul(av[i], bv[i]);
+        end = omp_get_wtime();
+        delta = end - start;
+        mhz = VECTOR_N*t / delta;
+        mhz /= 1e6;
+
+        cout << VECTOR_N*t << " muls with wide mul in time: " <<
+            delta << " s or " << mhz << " Mhz" << endl;
+    }
+
+    if (global::F->get_n() <= 16)
+    {
+        start = omp_get_wtime();
+        for (uint64_t i = 0; i < t; i++)
+            pv[i] = global::F->wide_mul_n(av[i], bv[i]);
+        end = omp_get_wtime();
+        delta = end - start;
+        mhz = VECTOR_N*t / delta;
+        mhz /= 1e6;
+
+        cout << VECTOR_N*t << " muls with generic wide mul in time: " <<
+            delta << " s or " << mhz << " Mhz" << endl;
+    }
+
+    if (global::F->get_n() == 32)
+    {
+        start = omp_get_wtime();
+        for (uint64_t i = 0; i < t; i++)
+            pv[i] = global::F->wide_mul_32(av[i], bv[i]);
+        end = omp_get_wtime();
+        delta = end - start;
+        mhz = VECTOR_N_64*t / delta;
+        mhz /= 1e6;
+
+        cout << VECTOR_N_64*t << " muls with 64-bit lane wide mul in time: " <<
+            delta << " s or " << mhz << " Mhz" << endl;
+    }
+
     start = omp_get_wtime();
     for (uint64_t i = 0; i < t; i++)
-        pv[i] = global::F->wide_mul(av[i], bv[i]);
+        pv[i] = global::F->wide_mul_n_64(av[i], bv[i]);
     end = omp_get_wtime();
     delta = end - start;
-    mhz = VECTOR_N*t / delta;
+    mhz = VECTOR_N_64*t / delta;
     mhz /= 1e6;
 
-    cout << VECTOR_N*t << " muls with wide mul in time: " <<
+    cout << VECTOR_N_64*t << " muls with generic 64-bit lane wide mul in time: " <<
         delta << " s or " << mhz << " Mhz" << endl;
 
+    /* the squares and inversions with the kernels of the field */
+    if (n == 16)
+        bench_wide<Wide_16>(av, pv, "wide");
+    if (n <= 16)
+        bench_wide<Wide_n>(av, pv, "generic wide");
+    if (n == 32)
+        bench_wide<Wide_32>(av, pv, "64-bit lane wide");
+    bench_wide<Wide_n_64>(av, pv, "generic 64-bit lane wide");
+
     return 0;
 }
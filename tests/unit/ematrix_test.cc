@@ -1,44 +1,53 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <iostream>
 #include <valarray>
+#include <vector>
+#include <memory>
 
 #include "ematrix_test.hh"
 #include "../../src/global.hh"
 #include "../../src/ematrix.hh"
 #include "../../src/extension.hh"
+#include "../../src/row_override.hh"
 
 using namespace std;
 
-EMatrix EMatrix_test::random()
+template <typename F>
+EMatrix<F> EMatrix_test<F>::random()
 {
-    valarray<GR_element> m(this->dim * this->dim);
+    valarray<GR_element<R>> m(this->dim * this->dim);
 
     for (int row = 0; row < this->dim; row++)
         for (int col = 0; col < this->dim; col++)
-            m[row*this->dim + col] = util::GR_random();
+            m[row*this->dim + col] = util::GR_random<R>();
 
-    return EMatrix(this->dim, m);
+    return EMatrix<F>(this->dim, m);
 }
 
-GR_element EMatrix_test::term(valarray<int> &perm, const EMatrix &m)
+template <typename F>
+GR_element<typename F::Ring>
+EMatrix_test<F>::term(valarray<int> &perm, const EMatrix<F> &m)
 {
-    GR_element ret = util::GR_one();
+    GR_element<R> ret = util::GR_one<R>();
     for (int col = 0; col < this->dim; col++)
         ret *= m(perm[col], col);
     return ret;
 }
 
-void EMatrix_test::swap(int i1, int i2, valarray<int> &perm)
+template <typename F>
+void EMatrix_test<F>::swap(int i1, int i2, valarray<int> &perm)
 {
     int tmp = perm[i1];
     perm[i1] = perm[i2];
     perm[i2] = tmp;
 }
 
-GR_element EMatrix_test::per_m_det_heap(const EMatrix &m)
+template <typename F>
+GR_element<typename F::Ring>
+EMatrix_test<F>::per_m_det_heap(const EMatrix<F> &m)
 {
-    GR_element per = util::GR_zero();
-    GR_element det = util::GR_zero();
+    GR_element<R> per = util::GR_zero<R>();
+    GR_element<R> det = util::GR_zero<R>();
 
     /* iterative heaps algo for permutations. compute permanent
      * and determinant with the Leibniz formula */
@@ -46,7 +55,7 @@ GR_element EMatrix_test::per_m_det_heap(const EMatrix &m)
     valarray<int> perm(0, this->dim);
     for (int i = 0; i < this->dim; i++)
         perm[i] = i;
-    GR_element tt = this->term(perm, m);
+    GR_element<R> tt = this->term(perm, m);
     per += tt;
     det += tt;
 
@@ -80,27 +89,29 @@ GR_element EMatrix_test::per_m_det_heap(const EMatrix &m)
     return per - det;
 }
 
-bool EMatrix_test::test_per_det()
+template <typename F>
+bool EMatrix_test<F>::test_per_det()
 {
     cout << "per minus det: ";
     int err = 0;
     for (int t = 0; t < this->tests; t++)
     {
-        EMatrix m = this->random();
-        GR_element pd = this->per_m_det_heap(m);
+        EMatrix<F> m = this->random();
+        GR_element<R> pd = this->per_m_det_heap(m);
         if (pd != m.per_m_det())
             err++;
     }
     return this->end_test(err);
 }
 
-bool EMatrix_test::test_per_det_singular()
+template <typename F>
+bool EMatrix_test<F>::test_per_det_singular()
 {
     cout << "per minus det singular: ";
     int err = 0;
     for (int t = 0; t < this->tests; t++)
     {
-        EMatrix m = this->random();
+        EMatrix<F> m = this->random();
         int r1 = global::randgen() % this->dim;
         int r2 = global::randgen() % this->dim;
         while (r1 == r2)
@@ -110,9 +121,99 @@ bool EMatrix_test::test_per_det_singular()
         for (int col = 0; col < this->dim; col++)
             m.set(r1, col, m(r2, col));
 
-        GR_element pd = this->per_m_det_heap(m);
+        GR_element<R> pd = this->per_m_det_heap(m);
         if (pd != m.per_m_det())
             err++;
     }
     return this->end_test(err);
 }
+
+template <typename F>
+bool EMatrix_test<F>::test_row_op_per_projection()
+{
+    cout << "row op per projection: ";
+    int err = 0;
+    for (int t = 0; t < this->tests; t++)
+    {
+        EMatrix<F> m = this->random();
+        shared_ptr<FMatrix<F>> P = make_shared<FMatrix<F>>(m.project());
+        vector<Row_override<F>> minors;
+
+        /* sweep the columns like per_m_det */
+        valarray<bool> rows(false, this->dim);
+        for (int j = 0; j < this->dim; j++)
+        {
+            for (int i1 = 0; i1 < this->dim; i1++)
+            {
+                if (rows[i1] || m(i1, j).is_even())
+                    continue;
+                m.row_op_per(i1, j, P, minors);
+                rows[i1] = true;
+                break;
+            }
+            if (*P != m.project())
+                err++;
+        }
+    }
+    return this->end_test(err);
+}
+
+/* the views left in minors see the projection from before the columns
+ * that changed it in place */
+template <typename F>
+bool EMatrix_test<F>::test_row_op_per_minors()
+{
+    cout << "row op per minors: ";
+    int err = 0;
+    for (int t = 0; t < this->tests; t++)
+    {
+        EMatrix<F> m = this->random();
+        shared_ptr<FMatrix<F>> P = make_shared<FMatrix<F>>(m.project());
+        vector<Row_override<F>> minors;
+        /* the M'' of the views in minors */
+        vector<FMatrix<F>> expect;
+
+        valarray<bool> rows(false, this->dim);
+        for (int j = 0; j < this->dim; j++)
+        {
+            int i1;
+            for (i1 = 0; i1 < this->dim; i1++)
+                if (!rows[i1] && !m(i1, j).is_even())
+                    break;
+            if (i1 == this->dim)
+                continue;
+            rows[i1] = true;
+
+            FMatrix<F> M = m.project();
+            const GF_element<F> sigma_inv = M(i1, j).inv();
+            for (int i2 = 0; i2 < this->dim; i2++)
+            {
+                if (i2 == i1 || m(i2, j).is_even())
+                    continue;
+                const GF_element<F> tp = sigma_inv * M(i2, j);
+                FMatrix<F> minor = M;
+                for (int col = 0; col < this->dim; col++)
+                {
+                    minor.set(i2, col, tp * M(i1, col));
+                    M.set(i2, col, M(i2, col) + tp * M(i1, col));
+                }
+                expect.push_back(minor);
+            }
+
+            m.row_op_per(i1, j, P, minors);
+            /* full vectors of views are removed from the front */
+            const unsigned int first = expect.size() - minors.size();
+            for (unsigned int k = 0; k < minors.size(); k++)
+                for (int row = 0; row < this->dim; row++)
+                    for (int col = 0; col < this->dim; col++)
+                        if (minors[k](row, col)
+                            != expect[first + k](row, col))
+                            err++;
+        }
+    }
+    return this->end_test(err);
+}
+
+template class EMatrix_test<GF2_16>;
+template class EMatrix_test<GF2_32>;
+template class EMatrix_test<GF2_generic>;
@@ -7,18 +7,23 @@
 #include "test.hh"
 #include "../../src/ematrix.hh"
 
+template <typename F>
 class EMatrix_test : public Test
 {
 private:
+    typedef typename F::Ring R;
+
     int dim = 5;
 
     bool test_per_det();
     bool test_per_det_singular();
+    bool test_row_op_per_projection();
+    bool test_row_op_per_minors();
 
-    EMatrix random();
-    GR_element term(std::valarray<int> &perm, const EMatrix &m);
+    EMatrix<F> random();
+    GR_element<R> term(std::valarray<int> &perm, const EMatrix<F> &m);
     void swap(int i1, int i2, std::valarray<int> &perm);
-    GR_element per_m_det_heap(const EMatrix &m);
+    GR_element<R> per_m_det_heap(const EMatrix<F> &m);
 
 public:
     using Test::Test;
@@ -27,7 +32,8 @@ public:
     {
         this->start_tests("ematrix");
 
-        return test_per_det() | test_per_det_singular();
+        return test_per_det() | test_per_det_singular()
+            | test_row_op_per_projection() | test_row_op_per_minors();
     }
 };
 
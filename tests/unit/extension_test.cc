@@ -7,60 +7,64 @@
 
 using namespace std;
 
-bool GR_test::test_add_inverse()
+template <typename R>
+bool GR_test<R>::test_add_inverse()
 {
     cout << "add inverse: ";
     int err = 0;
     for (int i = 0; i < this->tests; i++)
     {
-        GR_element e = util::GR_random();
-        if (e - e != util::GR_zero())
+        GR_element<R> e = util::GR_random<R>();
+        if (e - e != util::GR_zero<R>())
             err++;
     }
     return this->end_test(err);
 }
 
-bool GR_test::test_associativity()
+template <typename R>
+bool GR_test<R>::test_associativity()
 {
     cout << "test associativity: ";
     int err = 0;
     for (int i = 0; i < this->tests; i++)
     {
-        GR_element a = util::GR_random();
-        GR_element b = util::GR_random();
-        GR_element c = util::GR_random();
+        GR_element<R> a = util::GR_random<R>();
+        GR_element<R> b = util::GR_random<R>();
+        GR_element<R> c = util::GR_random<R>();
         if (a*(b+c) != c*a + b*a)
             err++;
     }
     return this->end_test(err);
 }
 
-bool GR_test::test_mul()
+template <typename R>
+bool GR_test<R>::test_mul()
 {
     cout << "test mul: ";
     int err = 0;
     for (int i = 0; i < this->tests; i++)
     {
-        GR_element a = util::GR_random();
-        GR_element b = util::GR_random();
+        GR_element<R> a = util::GR_random<R>();
+        GR_element<R> b = util::GR_random<R>();
 
-        if (a*b != b*a || a*util::GR_one() != a
-            || b*util::GR_one() != b
-            || a*util::GR_zero() != util::GR_zero()
-            || b*util::GR_zero() != util::GR_zero())
+        if (a*b != b*a || a*util::GR_one<R>() != a
+            || b*util::GR_one<R>() != b
+            || a*util::GR_zero<R>() != util::GR_zero<R>()
+            || b*util::GR_zero<R>() != util::GR_zero<R>())
             err++;
     }
     return this->end_test(err);
 }
 
-bool GR_test::test_fast_mul()
+template <typename R>
+bool GR_test<R>::test_fast_mul()
 {
     cout << "test fast mul: ";
     int err = 0;
     for (int i = 0; i < this->tests; i++)
     {
-        GR_element a = util::GR_random();
-        GR_element b = util::GR_random();
+        GR_element<R> a = util::GR_random<R>();
+        GR_element<R> b = util::GR_random<R>();
 
         GR_repr ref = global::E->ref_mul(a.get_repr(), b.get_repr());
         GR_repr fast = global::E->fast_mul(a.get_repr(), b.get_repr());
@@ -71,14 +75,15 @@ bool GR_test::test_fast_mul()
     return this->end_test(err);
 }
 
-bool GR_test::test_kronecker_mul()
+template <typename R>
+bool GR_test<R>::test_kronecker_mul()
 {
     cout << "test kronecker mul: ";
     int err = 0;
     for (int i = 0; i < this->tests; i++)
     {
-        GR_element a = util::GR_random();
-        GR_element b = util::GR_random();
+        GR_element<R> a = util::GR_random<R>();
+        GR_element<R> b = util::GR_random<R>();
 
         GR_repr ref = global::E->ref_mul(a.get_repr(), b.get_repr());
         GR_repr kron = global::E->kronecker_mul(a.get_repr(), b.get_repr());
@@ -89,14 +94,15 @@ bool GR_test::test_kronecker_mul()
     return this->end_test(err);
 }
 
-bool GR_test::test_intel_rem()
+template <typename R>
+bool GR_test<R>::test_intel_rem()
 {
     cout << "test intel rem: ";
     int err = 0;
     for (int i = 0; i < this->tests; i++)
     {
-        GR_element a = util::GR_random();
-        GR_element b = util::GR_random();
+        GR_element<R> a = util::GR_random<R>();
+        GR_element<R> b = util::GR_random<R>();
         GR_repr v = global::E->fast_mul(a.get_repr(), b.get_repr());
 
         GR_repr euclid = global::E->euclid_rem(v);
@@ -108,7 +114,35 @@ bool GR_test::test_intel_rem()
     return this->end_test(err);
 }
 
-bool GR_test::test_mont_rem()
+/* mul and rem of the ring R, compiled for the rings of GR4<N, MOD>,
+ * compared to the reference implementations */
+template <typename R>
+bool GR_test<R>::test_specialized()
+{
+    cout << "test specialized mul and rem: ";
+    int err = 0;
+    for (int i = 0; i < this->tests; i++)
+    {
+        GR_element<R> a = util::GR_random<R>();
+        GR_element<R> b = util::GR_random<R>();
+
+        GR_repr ref = global::E->ref_mul(a.get_repr(), b.get_repr());
+        GR_repr prod = R::mul(a.get_repr(), b.get_repr());
+
+        if (prod.hi != ref.hi || prod.lo != ref.lo)
+            err++;
+
+        GR_repr euclid = global::E->euclid_rem(ref);
+        GR_repr rem = R::rem(prod);
+
+        if (euclid.hi != rem.hi || euclid.lo != rem.lo)
+            err++;
+    }
+    return this->end_test(err);
+}
+
+template <typename R>
+bool GR_test<R>::test_mont_rem()
 {
     cout << "test montgomery multiplication: ";
     int err = 0;
@@ -143,33 +177,40 @@ bool GR_test::test_mont_rem()
     return this->end_test(err);
 }
 
-bool GR_test::test_even_tau()
+template <typename R>
+bool GR_test<R>::test_even_tau()
 {
     cout << "test even tau: ";
     int err = 0;
     for (int i = 0; i < this->tests; i++)
     {
-        GR_element sigma = util::GR_random();
-        GR_element v = util::GR_random();
+        GR_element<R> sigma = util::GR_random<R>();
+        GR_element<R> v = util::GR_random<R>();
         if (sigma.is_even() || v.is_even())
             /* we get here with probability (0.5)^(d-1) */
             continue;
-        GR_element e = v - sigma * util::tau(sigma, v);
+        GR_element<R> sigma_inv = sigma.project().inv().lift();
+        GR_element<R> e = v - sigma * util::tau(sigma_inv, v);
         if (!e.is_even())
             err++;
     }
     return this->end_test(err);
 }
 
-bool GR_test::test_is_even()
+template <typename R>
+bool GR_test<R>::test_is_even()
 {
     cout << "test is even: ";
     int err = 0;
     for (int i = 0; i < this->tests; i++)
     {
-        GR_element e(global::randgen() & global::E->get_mask(), 0x0);
+        GR_element<R> e(global::randgen() & R::get_mask(), 0x0);
         if (!e.is_even())
             err++;
     }
     return this->end_test(err);
 }
+
+template class GR_test<GR4_16>;
+template class GR_test<GR4_32>;
+template class GR_test<GR4_generic>;
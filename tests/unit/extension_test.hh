@@ -4,6 +4,8 @@
 
 #include "test.hh"
 
+/* tests of the ring R, see GR_element */
+template <typename R>
 class GR_test : public Test
 {
 private:
@@ -18,6 +20,7 @@ private:
     bool test_even_tau();
     bool test_is_even();
     bool test_kronecker_mul();
+    bool test_specialized();
 
 public:
     using Test::Test;
@@ -29,7 +32,7 @@ public:
         return test_add_inverse() | test_associativity()
             | test_mul() | test_even_tau() | test_is_even()
             | test_fast_mul() | test_intel_rem() | test_mont_rem()
-            | test_kronecker_mul();
+            | test_kronecker_mul() | test_specialized();
     }
 };
 
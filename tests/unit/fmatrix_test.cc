@@ -1,6 +1,9 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <iostream>
 #include <valarray>
+#include <vector>
+#include <utility>
+#include <memory>
 
 #include "fmatrix_test.hh"
 #include "../../src/global.hh"
@@ -8,19 +11,24 @@
 #include "../../src/gf.hh"
 #include "../../src/polynomial.hh"
 #include "../../src/packed_fmatrix.hh"
+#include "../../src/batched_fmatrix.hh"
+#include "../../src/lane_fmatrix.hh"
+#include "../../src/row_override.hh"
+#include "../../src/small_det.hh"
 
 using namespace std;
 
-FMatrix FMatrix_test::vandermonde()
+template <typename F>
+FMatrix<F> FMatrix_test<F>::vandermonde()
 {
-    valarray<GF_element> m(this->dim * this->dim);
-    uint64_t v = global::F->rem(global::randgen());
+    valarray<GF_element<F>> m(this->dim * this->dim);
+    uint64_t v = F::rem(global::randgen());
 
     for (int row = 0; row < this->dim; row++)
     {
-        const GF_element e = GF_element(v);
-        v = global::F->rem(v + 2);
-        GF_element prod = util::GF_one();
+        const GF_element<F> e = GF_element<F>(v);
+        v = F::rem(v + 2);
+        GF_element<F> prod = util::GF_one<F>();
 
         for (int col = 0; col < this->dim; col++)
         {
@@ -29,27 +37,30 @@ FMatrix FMatrix_test::vandermonde()
         }
     }
 
-    return FMatrix(this->dim, m);
+    return FMatrix<F>(this->dim, m);
 }
 
-GF_element FMatrix_test::term(valarray<int> &perm, const FMatrix &m)
+template <typename F>
+GF_element<F> FMatrix_test<F>::term(valarray<int> &perm, const FMatrix<F> &m)
 {
-    GF_element ret = util::GF_one();
+    GF_element<F> ret = util::GF_one<F>();
     for (int col = 0; col < m.get_n(); col++)
         ret *= m(perm[col], col);
     return ret;
 }
 
-void FMatrix_test::swap(int i1, int i2, valarray<int> &perm)
+template <typename F>
+void FMatrix_test<F>::swap(int i1, int i2, valarray<int> &perm)
 {
     int tmp = perm[i1];
     perm[i1] = perm[i2];
     perm[i2] = tmp;
 }
 
-GF_element FMatrix_test::det_heap(const FMatrix &m)
+template <typename F>
+GF_element<F> FMatrix_test<F>::det_heap(const FMatrix<F> &m)
 {
-    GF_element det = util::GF_zero();
+    GF_element<F> det = util::GF_zero<F>();
 
     int n = m.get_n();
 
@@ -59,7 +70,7 @@ GF_element FMatrix_test::det_heap(const FMatrix &m)
     valarray<int> perm(0, n);
     for (int i = 0; i < n; i++)
         perm[i] = i;
-    GF_element tt = this->term(perm, m);
+    GF_element<F> tt = this->term(perm, m);
     det += tt;
 
     int i = 0;
@@ -86,28 +97,30 @@ GF_element FMatrix_test::det_heap(const FMatrix &m)
     return det;
 }
 
-FMatrix FMatrix_test::random(int n = 0)
+template <typename F>
+FMatrix<F> FMatrix_test<F>::random(int n)
 {
     if (!n)
         n = this->dim;
-    valarray<GF_element> m(n * n);
+    valarray<GF_element<F>> m(n * n);
 
     for (int row = 0; row < n; row++)
         for (int col = 0; col < n; col++)
-            m[row*n + col] = util::GF_random();
+            m[row*n + col] = util::GF_random<F>();
 
-    return FMatrix(n, m);
+    return FMatrix<F>(n, m);
 }
 
-bool FMatrix_test::test_determinant_vandermonde()
+template <typename F>
+bool FMatrix_test<F>::test_determinant_vandermonde()
 {
     cout << "determinant vandermonde: ";
     int err = 0;
     for (int t = 0; t < this->tests; t++)
     {
-        FMatrix vander = this->vandermonde();
+        FMatrix<F> vander = this->vandermonde();
 
-        GF_element det = util::GF_one();
+        GF_element<F> det = util::GF_one<F>();
         for (int i = 0; i < this->dim; i++)
             for (int j = i+1; j < this->dim; j++)
                 det *= vander(j, 1) - vander(i, 1);
@@ -118,27 +131,60 @@ bool FMatrix_test::test_determinant_vandermonde()
     return this->end_test(err);
 }
 
-bool FMatrix_test::test_determinant_random()
+template <typename F>
+bool FMatrix_test<F>::test_determinant_random()
 {
     cout << "determinant random: ";
     int err = 0;
     for (int t = 0; t < this->tests; t++)
     {
-        FMatrix m = this->random(5);
-        GF_element d = this->det_heap(m);
+        FMatrix<F> m = this->random(5);
+        GF_element<F> d = this->det_heap(m);
         if (d != m.det())
             err++;
     }
     return this->end_test(err);
 }
 
-bool FMatrix_test::test_det_singular()
+/* large enough for the row operations to be split to tasks */
+template <typename F>
+bool FMatrix_test<F>::test_determinant_parallel()
+{
+    cout << "determinant with parallel elimination: ";
+    int err = 0;
+    const int n = PARALLEL_ROWS + 5;
+    for (int t = 0; t < this->tests / 100 + 1; t++)
+    {
+        const FMatrix<F> m = this->random(n);
+        FMatrix<F> A(n);
+        A.copy(m);
+        const GF_element<F> ref = A.det();
+        const GF_element<F> ref_sum = m.pdet_low_sum(0, n - 1);
+
+        GF_element<F> det;
+        GF_element<F> sum;
+        A.copy(m);
+        #pragma omp parallel
+        #pragma omp single
+        {
+            det = A.det();
+            sum = m.pdet_low_sum(0, n - 1);
+        }
+
+        if (det != ref || sum != ref_sum)
+            err++;
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool FMatrix_test<F>::test_det_singular()
 {
     cout << "determinant on singular matrices: ";
     int err = 0;
     for (int t = 0; t < this->tests; t++)
     {
-        FMatrix m = this->random();
+        FMatrix<F> m = this->random();
         int r1 = global::randgen() % this->dim;
         int r2 = global::randgen() % this->dim;
         while (r1 == r2)
@@ -148,33 +194,34 @@ bool FMatrix_test::test_det_singular()
         for (int col = 0; col < this->dim; col++)
             m.set(r1, col, m(r2, col));
 
-        if (m.det() != util::GF_zero())
+        if (m.det() != util::GF_zero<F>())
             err++;
     }
     return this->end_test(err);
 }
 
-bool FMatrix_test::test_pdet()
+template <typename F>
+bool FMatrix_test<F>::test_pdet()
 {
     cout << "polynomial determinant: ";
     int err = 0;
     int reps = 10;
     for (int t = 0; t < this->tests / reps; t++)
     {
-        FMatrix m = this->random();
+        FMatrix<F> m = this->random();
         int r1 = global::randgen() % this->dim;
         int r2 = global::randgen() % this->dim;
         while (r1 == r2)
             r2 = global::randgen() % this->dim;
 
-        Polynomial pdet = m.pdet(r1, r2);
-        FMatrix A(m.get_n());
+        Polynomial<F> pdet = m.pdet(r1, r2);
+        FMatrix<F> A(m.get_n());
         for (int i = 0; i < reps; i++)
         {
-            GF_element gamma = util::GF_random();
+            GF_element<F> gamma = util::GF_random<F>();
             A.copy(m);
             A.mul_gamma(r1, r2, gamma);
-            GF_element d = A.det();
+            GF_element<F> d = A.det();
             if (pdet.eval(gamma) != d)
                 err++;
         }
@@ -182,33 +229,155 @@ bool FMatrix_test::test_pdet()
     return this->end_test(err);
 }
 
-bool FMatrix_test::test_packed_determinant()
+template <typename F>
+bool FMatrix_test<F>::test_pdet_singular()
+{
+    cout << "polynomial determinant singular: ";
+    int err = 0;
+    for (int t = 0; t < this->tests; t++)
+    {
+        FMatrix<F> m = this->random();
+        int r1 = global::randgen() % this->dim;
+        int r2 = global::randgen() % this->dim;
+        while (r1 == r2)
+            r2 = global::randgen() % this->dim;
+
+        /* make two rows other than r1 and r2 equal, if possible.
+         * otherwise make r1 and r2 equal. */
+        int r3 = 0;
+        while (r3 == r1 || r3 == r2)
+            r3++;
+        int r4 = r3 + 1;
+        while (r4 == r1 || r4 == r2)
+            r4++;
+        if (r4 >= this->dim)
+        {
+            r3 = r1;
+            r4 = r2;
+        }
+        for (int col = 0; col < this->dim; col++)
+            m.set(r3, col, m(r4, col));
+
+        Polynomial<F> pdet = m.pdet(r1, r2);
+        GF_element<F> gamma = util::GF_random<F>();
+        FMatrix<F> A(m.get_n());
+        A.copy(m);
+        A.mul_gamma(r1, r2, gamma);
+
+        if (pdet.eval(gamma) != A.det())
+            err++;
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool FMatrix_test<F>::test_pdet_interpolation()
+{
+    cout << "polynomial determinant interpolation: ";
+    int err = 0;
+    int reps = 10;
+    /* shared by all the matrices */
+    const Interpolation_plan<F> plans[] = {
+        Interpolation_plan<F>(2*this->dim - 1, RANDOM_POINTS),
+        Interpolation_plan<F>(2*this->dim - 1, SUBSPACE_POINTS)
+    };
+    for (int t = 0; t < this->tests / reps; t++)
+    {
+        FMatrix<F> m = this->random();
+        int r1 = global::randgen() % this->dim;
+        int r2 = global::randgen() % this->dim;
+        while (r1 == r2)
+            r2 = global::randgen() % this->dim;
+
+        Polynomial<F> ref = m.pdet(r1, r2);
+        for (Det_engine engine : { SCALAR_DET, PACKED_DET, BATCHED_DET })
+        {
+            for (const Interpolation_plan<F> &plan : plans)
+            {
+                Polynomial<F> pdet = m.pdet_interpolation(r1, r2, plan, engine);
+                for (int i = 0; i <= 2*this->dim - 2; i++)
+                {
+                    if (ref[i] != pdet[i])
+                    {
+                        err++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        /* fresh points */
+        Polynomial<F> pdet =
+            m.pdet_interpolation(r1, r2, BATCHED_DET, RANDOM_POINTS);
+        for (int i = 0; i <= 2*this->dim - 2; i++)
+        {
+            if (ref[i] != pdet[i])
+            {
+                err++;
+                break;
+            }
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool FMatrix_test<F>::test_pdet_low_sum()
+{
+    cout << "polynomial determinant low sum: ";
+    int err = 0;
+    for (int t = 0; t < this->tests; t++)
+    {
+        FMatrix<F> m = this->random();
+        int r1 = global::randgen() % this->dim;
+        int r2 = global::randgen() % this->dim;
+        while (r1 == r2)
+            r2 = global::randgen() % this->dim;
+
+        Polynomial<F> pdet = m.pdet(r1, r2);
+        GF_element<F> sum = util::GF_zero<F>();
+        for (int i = 0; i < this->dim; i++)
+            sum += pdet[i];
+
+        if (sum != m.pdet_low_sum(r1, r2))
+            err++;
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+template <typename W>
+bool FMatrix_test<F>::test_packed_determinant()
 {
     cout << "determinant on packed matrices: ";
     int err = 0;
 
     for (int t = 0; t < this->tests; t++)
     {
-        FMatrix m = this->random();
-        Packed_FMatrix PA(this->dim, m);
+        FMatrix<F> m = this->random();
+        Packed_FMatrix<F, W> PA(this->dim, m);
+        PA.init();
+        GF_element<F> pack = PA.det();
         PA.init();
-        GF_element pack = PA.det();
-        GF_element ref = m.det();
+        GF_element<F> fraction_free = PA.det_fraction_free();
+        GF_element<F> ref = m.det();
 
-        if (pack != ref)
+        if (pack != ref || fraction_free != ref)
             err++;
     }
     return this->end_test(err);
 }
 
-bool FMatrix_test::test_packed_determinant_singular()
+template <typename F>
+template <typename W>
+bool FMatrix_test<F>::test_packed_determinant_singular()
 {
     cout << "determinant on packed singular matrices: ";
     int err = 0;
 
     for (int t = 0; t < this->tests; t++)
     {
-        FMatrix m = this->random();
+        FMatrix<F> m = this->random();
         int r1 = global::randgen() % this->dim;
         int r2 = global::randgen() % this->dim;
         while (r1 == r2)
@@ -218,32 +387,36 @@ bool FMatrix_test::test_packed_determinant_singular()
         for (int col = 0; col < this->dim; col++)
             m.set(r1, col, m(r2, col));
 
-        Packed_FMatrix PA(this->dim, m);
+        Packed_FMatrix<F, W> PA(this->dim, m);
+        PA.init();
+        GF_element<F> pack = PA.det();
         PA.init();
-        GF_element pack = PA.det();
-        GF_element ref = m.det();
+        GF_element<F> fraction_free = PA.det_fraction_free();
+        GF_element<F> ref = m.det();
 
-        if (pack != ref)
+        if (pack != ref || fraction_free != ref)
             err++;
     }
     return this->end_test(err);
 }
 
-bool FMatrix_test::test_packed_gamma_mul()
+template <typename F>
+template <typename W>
+bool FMatrix_test<F>::test_packed_gamma_mul()
 {
     cout << "packed gamma mul: ";
     int err = 0;
 
     for (int t = 0; t < this->tests; t++)
     {
-        GF_element gamma = util::GF_random();
+        GF_element<F> gamma = util::GF_random<F>();
         int r1 = global::randgen() % this->dim;
         int r2 = global::randgen() % this->dim;
         while (r1 == r2)
             r2 = global::randgen() % this->dim;
 
-        FMatrix A = this->random();
-        Packed_FMatrix PA(this->dim, A);
+        FMatrix<F> A = this->random();
+        Packed_FMatrix<F, W> PA(this->dim, A);
         PA.init();
 
         A.mul_gamma(r1, r2, gamma);
@@ -255,15 +428,17 @@ bool FMatrix_test::test_packed_gamma_mul()
     return this->end_test(err);
 }
 
-bool FMatrix_test::test_packed_init()
+template <typename F>
+template <typename W>
+bool FMatrix_test<F>::test_packed_init()
 {
 
     cout << "packed matrix init: ";
     int err = 0;
     for (int t = 0; t < this->tests; t++)
     {
-        FMatrix A = this->random();
-        Packed_FMatrix PA(this->dim, A);
+        FMatrix<F> A = this->random();
+        Packed_FMatrix<F, W> PA(this->dim, A);
         PA.init();
 
         if (A != PA.unpack())
@@ -271,3 +446,240 @@ bool FMatrix_test::test_packed_init()
     }
     return this->end_test(err);
 }
+
+/* every other matrix is singular, so that some lanes
+ * lack a pivot while others don't */
+template <typename F>
+template <typename W>
+bool FMatrix_test<F>::test_batched_determinant()
+{
+    constexpr int LANES = Batched_FMatrix<F, W>::lanes();
+    cout << "batched determinants: ";
+    int err = 0;
+
+    for (int t = 0; t < this->tests / LANES; t++)
+    {
+        FMatrix<F> m = this->random();
+        int r1 = global::randgen() % this->dim;
+        int r2 = global::randgen() % this->dim;
+        while (r1 == r2)
+            r2 = global::randgen() % this->dim;
+
+        /* r1 == r3 makes the lanes with gamma = 1 singular */
+        if (t % 2)
+        {
+            const int r3 = (r2 + 1 + global::randgen() % (this->dim - 1))
+                % this->dim;
+            for (int col = 0; col < this->dim; col++)
+                m.set(r1, col, m(r3, col));
+        }
+
+        GF_element<F> gamma[LANES];
+        GF_element<F> delta[LANES];
+        for (int i = 0; i < LANES; i++)
+            gamma[i] = (i % 2) ? util::GF_one<F>() : util::GF_random<F>();
+
+        Batched_FMatrix<F, W> BA(m, r1, r2);
+        BA.init(gamma);
+        BA.det(delta);
+
+        for (int i = 0; i < LANES; i++)
+        {
+            FMatrix<F> A = m;
+            A.mul_gamma(r1, r2, gamma[i]);
+            if (A.det() != delta[i])
+                err++;
+        }
+    }
+    return this->end_test(err);
+}
+
+/* a different matrix, r1 and r2 in each lane. in every third lane two
+ * rows other than r1 and r2 are equal and the low sum is zero */
+template <typename F>
+template <typename W>
+bool FMatrix_test<F>::test_lane_low_sums()
+{
+    constexpr int LANES = Lane_FMatrix<F, W>::lanes();
+    cout << "lane low sums: ";
+    int err = 0;
+
+    for (int t = 0; t < this->tests / LANES; t++)
+    {
+        /* fewer matrices than lanes in some of the tests */
+        const int count = 1 + t % LANES;
+        vector<FMatrix<F>> m;
+        vector<pair<int, int>> rows;
+        for (int i = 0; i < count; i++)
+        {
+            m.push_back(this->random());
+            int r1 = global::randgen() % this->dim;
+            int r2 = global::randgen() % this->dim;
+            while (r1 == r2)
+                r2 = global::randgen() % this->dim;
+            rows.emplace_back(r1, r2);
+
+            int r3 = 0;
+            while (r3 == r1 || r3 == r2)
+                r3++;
+            int r4 = r3 + 1;
+            while (r4 == r1 || r4 == r2)
+                r4++;
+            if (i % 3 == 2 && r4 < this->dim)
+                for (int col = 0; col < this->dim; col++)
+                    m[i].set(r3, col, m[i](r4, col));
+        }
+
+        GF_element<F> sums[LANES];
+        Lane_FMatrix<F, W> L(m, rows, 0);
+        L.pdet_low_sums(sums);
+
+        for (int i = 0; i < count; i++)
+            if (sums[i] != m[i].pdet_low_sum(rows[i].first, rows[i].second))
+                err++;
+    }
+    return this->end_test(err);
+}
+
+/* the views of row_op_per, from two bases so that the lanes do not
+ * share the base */
+template <typename F>
+template <typename W>
+bool FMatrix_test<F>::test_lane_views()
+{
+    constexpr int LANES = Lane_FMatrix<F, W>::lanes();
+    cout << "lane low sums of views: ";
+    int err = 0;
+
+    for (int t = 0; t < this->tests / LANES; t++)
+    {
+        vector<Row_override<F>> views;
+        for (int b = 0; b < 2; b++)
+        {
+            const shared_ptr<const FMatrix<F>> base =
+                make_shared<const FMatrix<F>>(this->random());
+            const int i1 = global::randgen() % this->dim;
+            vector<GF_element<F>> mult(this->dim, util::GF_zero<F>());
+            for (int i2 = 0; i2 < this->dim && (int) views.size() < LANES;
+                 i2++)
+            {
+                if (i2 == i1 || global::randgen() % 2)
+                    continue;
+                mult[i2] = util::GF_random<F>();
+                views.emplace_back(base, i1, i2, mult);
+            }
+        }
+        if (views.empty())
+            continue;
+
+        GF_element<F> sums[LANES];
+        Lane_FMatrix<F, W> L(views, 0);
+        L.pdet_low_sums(sums);
+
+        for (unsigned int i = 0; i < views.size(); i++)
+        {
+            FMatrix<F> m(this->dim);
+            for (int row = 0; row < this->dim; row++)
+                for (int col = 0; col < this->dim; col++)
+                    m.set(row, col, views[i](row, col));
+            if (sums[i] != m.pdet_low_sum(views[i].get_i1(),
+                                          views[i].get_i2()))
+                err++;
+        }
+    }
+    return this->end_test(err);
+}
+
+/* every size of small_det for the field, every other matrix singular */
+template <typename F>
+bool FMatrix_test<F>::test_small_det()
+{
+    cout << "small determinants: ";
+    int err = 0;
+    for (int t = 0; t < this->tests / 10 + 1; t++)
+    {
+        for (int n = 2; n <= SMALL_DET_MAX; n++)
+        {
+            FMatrix<F> m = this->random(n);
+            if (t % 2)
+            {
+                const int r1 = global::randgen() % n;
+                const int r2 = (r1 + 1 + global::randgen() % (n - 1)) % n;
+                for (int col = 0; col < n; col++)
+                    m.set(r2, col, m(r1, col));
+            }
+            /* swaps rows at the first column */
+            if (t % 3 == 1)
+                m.set(0, 0, util::GF_zero<F>());
+
+            FMatrix<F> A(n);
+            A.copy(m);
+            if (m.det() != A.det_elimination())
+                err++;
+        }
+    }
+    return this->end_test(err);
+}
+
+/* some lanes are zero */
+template <typename F>
+template <typename W>
+bool FMatrix_test<F>::test_lane_inverse()
+{
+    constexpr int VECTOR_N = W::VECTOR_N;
+    cout << "lane inverses: ";
+    int err = 0;
+    uint64_t elems[VECTOR_N];
+    for (int t = 0; t < this->tests; t++)
+    {
+        for (int i = 0; i < VECTOR_N; i++)
+            elems[i] = (global::randgen() % 4)
+                ? util::GF_random<F>().get_repr() : 0x0;
+
+        uint64_t inv[VECTOR_N];
+        uint64_t it[VECTOR_N];
+        Lanes<W>::unpack(Lanes<W>::batch_inverse(Lanes<W>::pack(elems)), inv);
+        Lanes<W>::unpack(Lanes<W>::itoh_tsujii(Lanes<W>::pack(elems)), it);
+        for (int i = 0; i < VECTOR_N; i++)
+        {
+            const GF_element<F> e(elems[i]);
+            if (e == util::GF_zero<F>() && inv[i] != 0x0)
+                err++;
+            if (e != util::GF_zero<F>()
+                && e * GF_element<F>(inv[i]) != util::GF_one<F>())
+                err++;
+            if (it[i] != inv[i])
+                err++;
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+template <typename W>
+bool FMatrix_test<F>::test_packed()
+{
+    return test_packed_init<W>() | test_packed_determinant<W>()
+        | test_packed_determinant_singular<W>() | test_packed_gamma_mul<W>()
+        | test_batched_determinant<W>() | test_lane_low_sums<W>()
+        | test_lane_views<W>() | test_lane_inverse<W>();
+}
+
+/* all the packed multiplications that work on the field */
+template <typename F>
+bool FMatrix_test<F>::test_packed_all()
+{
+    const int n = F::get_n();
+    bool failure = test_packed<Wide_n_64>();
+    if (n == 16)
+        failure |= test_packed<Wide_16>();
+    if (n == 32)
+        failure |= test_packed<Wide_32>();
+    if (n <= 16)
+        failure |= test_packed<Wide_n>();
+    return failure;
+}
+
+template class FMatrix_test<GF2_16>;
+template class FMatrix_test<GF2_32>;
+template class FMatrix_test<GF2_generic>;
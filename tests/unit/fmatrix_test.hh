@@ -8,26 +8,38 @@
 #include "../../src/gf.hh"
 #include "../../src/fmatrix.hh"
 
+template <typename F>
 class FMatrix_test : public Test
 {
 private:
     int dim = 10;
 
-    GF_element det_heap(const FMatrix &m);
-    GF_element term(std::valarray<int> &perm, const FMatrix &m);
+    GF_element<F> det_heap(const FMatrix<F> &m);
+    GF_element<F> term(std::valarray<int> &perm, const FMatrix<F> &m);
     void swap(int i1, int i2, std::valarray<int> &perm);
 
     bool test_determinant_vandermonde();
     bool test_det_singular();
     bool test_determinant_random();
+    bool test_determinant_parallel();
     bool test_pdet();
-    bool test_packed_determinant();
-    bool test_packed_determinant_singular();
-    bool test_packed_gamma_mul();
-    bool test_packed_init();
+    bool test_pdet_singular();
+    bool test_pdet_interpolation();
+    bool test_pdet_low_sum();
+    bool test_small_det();
+    template <typename W> bool test_packed_determinant();
+    template <typename W> bool test_packed_determinant_singular();
+    template <typename W> bool test_packed_gamma_mul();
+    template <typename W> bool test_packed_init();
+    template <typename W> bool test_batched_determinant();
+    template <typename W> bool test_lane_low_sums();
+    template <typename W> bool test_lane_views();
+    template <typename W> bool test_lane_inverse();
+    template <typename W> bool test_packed();
+    bool test_packed_all();
 
-    FMatrix vandermonde();
-    FMatrix random(int n);
+    FMatrix<F> vandermonde();
+    FMatrix<F> random(int n = 0);
 
 public:
     using Test::Test;
@@ -38,14 +50,12 @@ public:
         if (d)
             this->dim = d;
 
-        bool failure = test_pdet() | test_determinant_vandermonde()
-            | test_determinant_random() | test_det_singular();
-
-        if (global::F->get_n() == 16)
-        {
-            failure |= test_packed_init() | test_packed_determinant()
-                | test_packed_determinant_singular() | test_packed_gamma_mul();
-        }
+        bool failure = test_pdet() | test_pdet_singular()
+            | test_pdet_interpolation() | test_pdet_low_sum()
+            | test_determinant_vandermonde()
+            | test_determinant_random() | test_det_singular()
+            | test_determinant_parallel() | test_small_det()
+            | test_packed_all();
 
         return failure;
     }
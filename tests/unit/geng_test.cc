@@ -3,45 +3,39 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include <cmath>
+#include <unistd.h>
 
 #include "geng_test.hh"
 #include "../../src/graph.hh"
 #include "../../src/solver.hh"
+#include "../../src/parser.hh"
+#include "../../src/csr.hh"
+#include "../../src/global.hh"
 
 using namespace std;
 
-bool Geng_test::test_geng()
+template <typename F>
+bool Geng_test<F>::test_geng()
 {
-    string line = "";
-    cin >> line;
-    this->n = stoi(line);
-    Solver s;
+    Graph_reader reader(STDIN_FILENO);
+    CSR adj;
+    Solver<F> s;
 
+    this->n = 0;
     int total = 0;
     int fail = 0;
     cout << "failed:" << endl;
-    do
+    while (reader.next(adj))
     {
-        vector<vector<int>> graph;
-        for (int i = 0; i < this->n; i++)
-        {
-            vector<int> vec;
-            cin >> line;
-            for (int j = 0; j < this->n; j++)
-            {
-                if (line[j] == '1')
-                    vec.push_back(j);
-            }
-            graph.push_back(vec);
-
-        }
-        Graph G(graph);
+        this->n = adj.get_n();
+        Graph<F> G(adj);
 
         int algo = s.shortest_even_cycle(G);
         int ref = s.shortest_even_cycle_brute(G);
         if (algo != ref)
         {
-            this->store_graph(graph, total);
+            this->store_graph(adj, total);
             fail++;
         }
         total++;
@@ -51,11 +45,22 @@ bool Geng_test::test_geng()
             cout << " (" << ((float) fail) / total * 100 << "%)";
             cout << flush;
         }
-    } while (cin >> line);
+    }
+
+    if (!reader.get_error().empty())
+    {
+        cout << "\r\033[31m" << reader.get_error() << "\033[0m" << endl;
+        return true;
+    }
+    if (total == 0)
+    {
+        cout << "\r\033[31mno graphs in the input\033[0m" << endl;
+        return true;
+    }
 
     /* each computation should succeed with probability (1 - 2^{-d})^n */
     const double error_lim =
-        1 - pow(1 - 1.0 / (1ull << global::F->get_n()), this->n);
+        1 - pow(1 - 1.0 / (1ull << F::get_n()), this->n);
     const double errorp = fail * (1.0 / total);
 
     /* require that atleast one compt failed always for a failed test */
@@ -73,7 +78,8 @@ bool Geng_test::test_geng()
     return failed;
 }
 
-void Geng_test::store_graph(const vector<vector<int>> &g, int id)
+template <typename F>
+void Geng_test<F>::store_graph(const CSR &g, int id)
 {
     ofstream file("geng-fail/" + to_string(this->n) + "/" + to_string(id));
 
@@ -83,10 +89,14 @@ void Geng_test::store_graph(const vector<vector<int>> &g, int id)
 
     for (int i = 0; i < this->n; i++)
     {
-        for (uint j = 0; j < g[i].size(); j++)
-            file << j << " ";
+        for (const int *v = g.begin(i); v != g.end(i); v++)
+            file << *v << " ";
         file << "\n";
     }
 
     file.close();
 }
+
+template class Geng_test<GF2_16>;
+template class Geng_test<GF2_32>;
+template class Geng_test<GF2_generic>;
@@ -2,10 +2,10 @@
 #ifndef GENG_TEST_H
 #define GENG_TEST_H
 
-#include <vector>
-
 #include "test.hh"
+#include "../../src/csr.hh"
 
+template <typename F>
 class Geng_test : Test
 {
 private:
@@ -13,7 +13,7 @@ private:
 
     bool test_geng();
 
-    void store_graph(const std::vector<std::vector<int>> &g, int id);
+    void store_graph(const CSR &g, int id);
 
 public:
     Geng_test() { };
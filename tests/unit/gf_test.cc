@@ -1,5 +1,6 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <iostream>
+#include <vector>
 #include <immintrin.h>
 
 #include "gf_test.hh"
@@ -13,79 +14,161 @@ using namespace std;
  * do at most 2^24 tests */
 constexpr uint64_t MAX_TESTS = 0xFFFFFF;
 
-bool GF_test::test_add_inverse()
+template <typename F>
+bool GF_test<F>::test_add_inverse()
 {
     cout << "add inverse: ";
     int err = 0;
     uint64_t i = 0;
-    while (i <= min(MAX_TESTS, global::F->get_mask()))
+    while (i <= min(MAX_TESTS, F::get_mask()))
     {
-        GF_element e(i);
-        if (e + e != util::GF_zero()
-            || e - e != util::GF_zero())
+        GF_element<F> e(i);
+        if (e + e != util::GF_zero<F>()
+            || e - e != util::GF_zero<F>())
             err++;
         i++;
     }
     return this->end_test(err);
 }
 
-bool GF_test::test_associativity()
+template <typename F>
+bool GF_test<F>::test_associativity()
 {
     cout << "test associativity: ";
     int err = 0;
     for (int i = 0; i < this->tests; i++)
     {
-        GF_element a = util::GF_random();
-        GF_element b = util::GF_random();
-        GF_element c = util::GF_random();
+        GF_element<F> a = util::GF_random<F>();
+        GF_element<F> b = util::GF_random<F>();
+        GF_element<F> c = util::GF_random<F>();
         if (a*(b+c) != c*a + b*a)
             err++;
     }
     return this->end_test(err);
 }
 
-bool GF_test::test_mul_id()
+template <typename F>
+bool GF_test<F>::test_mul_id()
 {
     cout << "mul with id: ";
     int err = 0;
     uint64_t i = 0;
     /* dont do more than 2^24 */
-    while (i <= min(MAX_TESTS, global::F->get_mask()))
+    while (i <= min(MAX_TESTS, F::get_mask()))
     {
-        GF_element e(i);
-        if (e * util::GF_one() != e)
+        GF_element<F> e(i);
+        if (e * util::GF_one<F>() != e)
             err++;
         i++;
     }
     return this->end_test(err);
 }
 
-bool GF_test::test_mul_inverse()
+template <typename F>
+bool GF_test<F>::test_mul_inverse()
 {
     cout << "mul with inverse: ";
     int err = 0;
     uint64_t i = 1;
     /* dont do more than 2^24 */
-    while (i <= min(MAX_TESTS, global::F->get_mask()))
+    while (i <= min(MAX_TESTS, F::get_mask()))
     {
-        GF_element e(i);
-        if (e / e != util::GF_one())
+        GF_element<F> e(i);
+        if (e / e != util::GF_one<F>())
             err++;
         i++;
     }
     return this->end_test(err);
 }
 
-bool GF_test::test_lift_project()
+/* some of the elements are zero */
+template <typename F>
+bool GF_test<F>::test_batch_inverse()
+{
+    cout << "batch inverse: ";
+    int err = 0;
+    for (int n = 0; n < 40; n++)
+    {
+        vector<GF_element<F>> a(n);
+        for (int i = 0; i < n; i++)
+            a[i] = (global::randgen() % 4)
+                ? util::GF_random<F>() : util::GF_zero<F>();
+
+        vector<GF_element<F>> inv(a);
+        util::batch_inverse(inv);
+        for (int i = 0; i < n; i++)
+        {
+            if (a[i] == util::GF_zero<F>() && inv[i] != util::GF_zero<F>())
+                err++;
+            if (a[i] != util::GF_zero<F>()
+                && a[i] * inv[i] != util::GF_one<F>())
+                err++;
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool GF_test<F>::test_sqr()
+{
+    cout << "square and itoh-tsujii inverse: ";
+    int err = 0;
+    uint64_t i = 0;
+    while (i <= min(MAX_TESTS, F::get_mask()))
+    {
+        if (F::sqr(i) != F::rem(F::clmul(i, i)))
+            err++;
+        const uint64_t inv = (i == 0) ? 0x0 : F::ext_euclid(i);
+        if (global::F->itoh_tsujii(i) != inv)
+            err++;
+        i++;
+    }
+    return this->end_test(err);
+}
+
+/* elements in the low halves of the lanes of 32 or 64 bits */
+template <typename F>
+bool GF_test<F>::test_wide_sqr(
+    __m256i (GF2_n::*sqr)(const __m256i &) const,
+    const int lanes
+)
+{
+    cout << "wide square with " << lanes << " lanes: ";
+    int err = 0;
+    for (int i = 0; i < this->tests / lanes; i++)
+    {
+        uint32_t e[8] = { };
+        for (int j = 0; j < lanes; j++)
+            e[(8 / lanes)*j] = global::randgen() & F::get_mask();
+
+        __m256i v = _mm256_setr_epi32(e[0], e[1], e[2], e[3],
+                                      e[4], e[5], e[6], e[7]);
+        v = (global::F->*sqr)(v);
+        uint32_t r[8];
+        _mm256_storeu_si256((__m256i *) r, v);
+
+        for (int j = 0; j < 8; j++)
+        {
+            const uint64_t sq = (j % (8 / lanes) == 0)
+                ? F::sqr(e[j]) : 0x0;
+            if (r[j] != sq)
+                err++;
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool GF_test<F>::test_lift_project()
 {
     cout << "lift project: ";
     int err = 0;
     uint64_t i = 0;
-    while (i <= min(MAX_TESTS, global::F->get_mask()))
+    while (i <= min(MAX_TESTS, F::get_mask()))
     {
-        GF_element e(i);
-        GR_element b(global::randgen() & global::E->get_mask(), i);
-        GR_element c(0x0, i);
+        GF_element<F> e(i);
+        GR_element<typename F::Ring> b(global::randgen() & F::get_mask(), i);
+        GR_element<typename F::Ring> c(0x0, i);
         if (e.lift().project() != e
             || b.project() != e
             || e.lift() != c)
@@ -96,7 +179,34 @@ bool GF_test::test_lift_project()
 }
 
 
-bool GF_test::test_wide_mul()
+/* compare rem to long division */
+template <typename F>
+bool GF_test<F>::test_rem()
+{
+    cout << "remainder: ";
+    int err = 0;
+    const int n = F::get_n();
+    const uint64_t mod = F::get_mod();
+    for (int i = 0; i < this->tests; i++)
+    {
+        const uint64_t a = F::clmul(
+            global::randgen() & F::get_mask(),
+            global::randgen() & F::get_mask()
+        );
+
+        uint64_t r = a;
+        for (int deg = 2*n - 2; deg >= n; deg--)
+            if ((r >> deg) & 1)
+                r ^= mod << (deg - n);
+
+        if (F::rem(a) != r)
+            err++;
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool GF_test<F>::test_wide_mul()
 {
     constexpr int WIDTH = 4;
     cout << "wide mul: ";
@@ -109,19 +219,19 @@ bool GF_test::test_wide_mul()
 
         for (int j = 0; j < WIDTH; j++)
         {
-            a[j] = global::randgen() & global::F->get_mask();
-            b[j] = global::randgen() & global::F->get_mask();
-            prod[j] = global::F->rem(
-                global::F->clmul(a[j], b[j])
+            a[j] = global::randgen() & F::get_mask();
+            b[j] = global::randgen() & F::get_mask();
+            prod[j] = F::rem(
+                F::clmul(a[j], b[j])
             );
 
-            uint64_t ta = global::randgen() & global::F->get_mask();
-            uint64_t tb = global::randgen() & global::F->get_mask();
+            uint64_t ta = global::randgen() & F::get_mask();
+            uint64_t tb = global::randgen() & F::get_mask();
             a[j] |= ta << 32;
             b[j] |= tb << 32;
 
-            prod[j] |= global::F->rem(
-                global::F->clmul(ta, tb)
+            prod[j] |= F::rem(
+                F::clmul(ta, tb)
             ) << 32;
         }
 
@@ -143,3 +253,52 @@ bool GF_test::test_wide_mul()
     }
     return this->end_test(err);
 }
+
+/* compares the packed multiplication against rem(clmul) on elements
+ * placed in the low halves of 64-bit lanes. works for both
+ * the 32-bit and 64-bit lane kernels. */
+template <typename F>
+bool GF_test<F>::test_wide_mul_64(
+    __m256i (GF2_n::*mul)(const __m256i &, const __m256i &) const
+)
+{
+    constexpr int WIDTH = 4;
+    cout << "wide mul (generic): ";
+    int err = 0;
+    for (int i = 0; i < this->tests / WIDTH; i++)
+    {
+        uint64_t a[WIDTH];
+        uint64_t b[WIDTH];
+        int64_t prod[WIDTH];
+
+        for (int j = 0; j < WIDTH; j++)
+        {
+            a[j] = global::randgen() & F::get_mask();
+            b[j] = global::randgen() & F::get_mask();
+            prod[j] = F::rem(
+                F::clmul(a[j], b[j])
+            );
+        }
+
+        __m256i aa = _mm256_set_epi64x(a[3], a[2], a[1], a[0]);
+        __m256i bb = _mm256_set_epi64x(b[3], b[2], b[1], b[0]);
+        __m256i pp = (global::F->*mul)(aa, bb);
+
+        if (prod[0] != _mm256_extract_epi64(pp, 0))
+            err++;
+
+        if (prod[1] != _mm256_extract_epi64(pp, 1))
+            err++;
+
+        if (prod[2] != _mm256_extract_epi64(pp, 2))
+            err++;
+
+        if (prod[3] != _mm256_extract_epi64(pp, 3))
+            err++;
+    }
+    return this->end_test(err);
+}
+
+template class GF_test<GF2_16>;
+template class GF_test<GF2_32>;
+template class GF_test<GF2_generic>;
@@ -5,6 +5,7 @@
 #include "test.hh"
 #include "../../src/gf.hh"
 
+template <typename F>
 class GF_test : Test
 {
 private:
@@ -14,8 +15,18 @@ private:
     bool test_associativity();
     bool test_mul_id();
     bool test_mul_inverse();
+    bool test_batch_inverse();
     bool test_lift_project();
+    bool test_rem();
     bool test_wide_mul();
+    bool test_wide_mul_64(
+        __m256i (GF2_n::*mul)(const __m256i &, const __m256i &) const
+    );
+    bool test_sqr();
+    bool test_wide_sqr(
+        __m256i (GF2_n::*sqr)(const __m256i &) const,
+        const int lanes
+    );
 
 public:
     GF_test() { };
@@ -25,11 +36,19 @@ public:
         this->start_tests("gf");
 
         bool failure = test_add_inverse() | test_associativity()
-            | test_mul_id() | test_mul_inverse()
-            | test_lift_project();
-
-        if (global::F->get_n() == 16)
-            failure |= test_wide_mul();
+            | test_mul_id() | test_mul_inverse() | test_batch_inverse()
+            | test_lift_project() | test_rem() | test_sqr();
+
+        if (F::get_n() == 16)
+            failure |= test_wide_mul() | test_wide_sqr(&GF2_n::wide_sqr, 8);
+        if (F::get_n() == 32)
+            failure |= test_wide_mul_64(&GF2_n::wide_mul_32)
+                | test_wide_sqr(&GF2_n::wide_sqr_32, 4);
+        if (F::get_n() <= 16)
+            failure |= test_wide_mul_64(&GF2_n::wide_mul_n)
+                | test_wide_sqr(&GF2_n::wide_sqr_n, 8);
+        failure |= test_wide_mul_64(&GF2_n::wide_mul_n_64)
+            | test_wide_sqr(&GF2_n::wide_sqr_n_64, 4);
 
         return failure;
     }
@@ -1,34 +1,126 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <iostream>
 #include <vector>
+#include <string>
+#include <sstream>
+#include <unistd.h>
+#include <omp.h>
 
 #include "solver_test.hh"
 #include "../../src/graph.hh"
 #include "../../src/global.hh"
 #include "../../src/solver.hh"
+#include "../../src/batch.hh"
 
 using namespace std;
 
-bool Solver_test::test_solver()
+template <typename F>
+vector<vector<int>> Solver_test<F>::random_graph()
+{
+    vector<vector<int>> adj(this->n, vector<int>());
+    for (int u = 0; u < this->n; u++)
+    {
+        for (int v = 0; v < this->n; v++)
+        {
+            if (u == v)
+                continue;
+            if ((global::randgen() & 0b11) == 0x0)
+                adj[u].push_back(v);
+        }
+    }
+    return adj;
+}
+
+template <typename F>
+bool Solver_test<F>::test_solver()
 {
     cout << "solver random graph test: ";
     int err = 0;
-    Solver s;
     for (int t = 0; t < this->tests; t++)
     {
-        vector<vector<int>> adj(this->n, vector<int>());
+        vector<vector<int>> adj = this->random_graph();
+        Graph<F> G(adj);
+        /* both kinds of evaluation points */
+        const Solver<F> s(t % 2 ? RANDOM_POINTS : SUBSPACE_POINTS);
+
+        if (s.shortest_even_cycle(G) != s.shortest_even_cycle_brute(G))
+            err++;
+    }
+
+    /* each computation should succeed with probability (1 - 2^{-d})^n */
+    const double error_lim =
+        1 - pow(1 - 1.0 / (1ull << F::get_n()), this->n);
+    const double errorp = err * (1.0 / this->tests);
+
+    /* require that atleast one compt failed always for a failed test */
+    const bool failed = (errorp >= error_lim) && (err > 1);
+
+    if (failed)
+        cout << "\033[31m";
+    else
+        cout << "\033[32m";
+    cout << err << " out of " << this->tests << " failed (";
+    cout << errorp * 100 << "%)" << "\033[0m" << endl;
+
+    return failed;
+}
+
+template <typename F>
+bool Solver_test<F>::test_decision()
+{
+    cout << "decision random graph test: ";
+    int err = 0;
+    Solver<F> s;
+    for (int t = 0; t < this->tests; t++)
+    {
+        vector<vector<int>> adj = this->random_graph();
+        Graph<F> G(adj);
+
+        if (s.has_even_cycle(G) != (s.shortest_even_cycle_brute(G) != -1))
+            err++;
+    }
+
+    /* each evaluation point fails with probability at most n / 2^d */
+    const double error_lim = this->n * 1.0 / (1ull << F::get_n());
+    const double errorp = err * (1.0 / this->tests);
+
+    const bool failed = (errorp >= error_lim) && (err > 1);
+
+    if (failed)
+        cout << "\033[31m";
+    else
+        cout << "\033[32m";
+    cout << err << " out of " << this->tests << " failed (";
+    cout << errorp * 100 << "%)" << "\033[0m" << endl;
+
+    return failed;
+}
+
+template <typename F>
+bool Solver_test<F>::test_components()
+{
+    cout << "solver graphs with many components: ";
+    int err = 0;
+    Solver<F> s;
+    /* vertices are split in to this many blocks. arcs between blocks
+     * only go forward, so each block is a union of components */
+    constexpr int BLOCKS = 3;
+    for (int t = 0; t < this->tests; t++)
+    {
+        vector<vector<int>> adj = this->random_graph();
         for (int u = 0; u < this->n; u++)
         {
-            for (int v = 0; v < this->n; v++)
+            vector<int> nbors;
+            for (uint i = 0; i < adj[u].size(); i++)
             {
-                if (u == v)
-                    continue;
-                if ((global::randgen() & 0b11) == 0x0)
-                    adj[u].push_back(v);
+                const int v = adj[u][i];
+                if (BLOCKS*u / this->n <= BLOCKS*v / this->n)
+                    nbors.push_back(v);
             }
+            adj[u] = nbors;
         }
 
-        Graph G(adj);
+        Graph<F> G(adj);
 
         if (s.shortest_even_cycle(G) != s.shortest_even_cycle_brute(G))
             err++;
@@ -36,10 +128,9 @@ bool Solver_test::test_solver()
 
     /* each computation should succeed with probability (1 - 2^{-d})^n */
     const double error_lim =
-        1 - pow(1 - 1.0 / (1ull << global::F->get_n()), this->n);
+        1 - pow(1 - 1.0 / (1ull << F::get_n()), this->n);
     const double errorp = err * (1.0 / this->tests);
 
-    /* require that atleast one compt failed always for a failed test */
     const bool failed = (errorp >= error_lim) && (err > 1);
 
     if (failed)
@@ -51,3 +142,209 @@ bool Solver_test::test_solver()
 
     return failed;
 }
+
+template <typename F>
+int Solver_test<F>::brute_reference(const vector<vector<int>> &adj,
+                                    const int start,
+                                    const int v,
+                                    const int depth,
+                                    vector<bool> &visited,
+                                    int len)
+{
+    visited[v] = true;
+    for (uint i = 0; i < adj[v].size(); i++)
+    {
+        const int u = adj[v][i];
+        if (!visited[u])
+            len = this->brute_reference(adj, start, u, depth + 1, visited, len);
+        else if (u == start && depth % 2 == 0 && depth < len)
+            len = depth;
+    }
+    visited[v] = false;
+    return len;
+}
+
+template <typename F>
+bool Solver_test<F>::test_brute()
+{
+    cout << "brute force against reference: ";
+    int err = 0;
+    Solver<F> s;
+    for (int t = 0; t < this->tests; t++)
+    {
+        vector<vector<int>> adj = this->random_graph();
+        Graph<F> G(adj);
+
+        int ref = this->n + 1;
+        for (int v = 0; v < this->n; v++)
+        {
+            vector<bool> visited(this->n, false);
+            ref = this->brute_reference(adj, v, v, 1, visited, ref);
+        }
+        if (ref == this->n + 1)
+            ref = -1;
+
+        if (s.shortest_even_cycle_brute(G) != ref)
+            err++;
+    }
+    return this->end_test(err);
+}
+
+/* more than 64 vertices for the multiword visited sets */
+template <typename F>
+bool Solver_test<F>::test_brute_long_cycle()
+{
+    cout << "brute force on long cycles: ";
+    int err = 0;
+    Solver<F> s;
+    for (int len : { 69, 70, 101, 130 })
+    {
+        /* a cycle through the vertices in random order */
+        vector<int> perm(len);
+        for (int i = 0; i < len; i++)
+            perm[i] = i;
+        for (int i = len - 1; i > 0; i--)
+            swap(perm[i], perm[global::randgen() % (i + 1)]);
+
+        vector<vector<int>> adj(len);
+        for (int i = 0; i < len; i++)
+            adj[perm[i]].push_back(perm[(i + 1) % len]);
+        Graph<F> G(adj);
+
+        if (s.shortest_even_cycle_brute(G) != (len % 2 ? -1 : len))
+            err++;
+    }
+    return this->end_test(err);
+}
+
+/* digraph6 of the graph */
+static string digraph6(const vector<vector<int>> &adj)
+{
+    const int n = adj.size();
+    vector<bool> bits(n * n + 5, false);
+    for (int u = 0; u < n; u++)
+        for (int v : adj[u])
+            bits[u*n + v] = true;
+
+    string s = "&" + string(1, 63 + n);
+    for (int k = 0; k < n * n; k += 6)
+    {
+        int c = 0;
+        for (int i = 0; i < 6; i++)
+            c = (c << 1) | bits[k + i];
+        s += (char) (63 + c);
+    }
+    return s;
+}
+
+/* results of the batch mode in input order. brute force is exact */
+template <typename F>
+bool Solver_test<F>::test_batch()
+{
+    cout << "batch mode: ";
+    int err = 0;
+    Solver<F> s;
+
+    char fname[] = "/tmp/digraph-batch-XXXXXX";
+    const int fd = mkstemp(fname);
+    if (fd == -1)
+        return this->end_test(1);
+
+    const int graphs = 1 + this->tests / 10;
+    vector<int> ref(graphs);
+    string stream;
+    for (int i = 0; i < graphs; i++)
+    {
+        vector<vector<int>> adj = this->random_graph();
+        Graph<F> G(adj);
+        ref[i] = s.shortest_even_cycle_brute(G);
+        stream += digraph6(adj) + "\n";
+    }
+    if (write(fd, stream.data(), stream.size()) != (long) stream.size())
+        err++;
+    close(fd);
+
+    for (const bool decide : { false, true })
+    {
+        Run_options opt;
+        opt.brute = true;
+        opt.decide = decide;
+
+        /* the results go to cout */
+        stringstream out;
+        streambuf *old = cout.rdbuf(out.rdbuf());
+        const bool output = global::output;
+        global::output = false;
+        const long solved = util::solve_batch<F>({ fname }, opt);
+        global::output = output;
+        cout.rdbuf(old);
+
+        if (solved != graphs)
+            err++;
+        for (int i = 0; i < graphs; i++)
+        {
+            string name;
+            int k;
+            out >> name >> k;
+            const int expected = (decide) ? ref[i] != -1 : ref[i];
+            if (name != string(fname) + ":" + to_string(i + 1) || k != expected)
+                err++;
+        }
+    }
+    unlink(fname);
+
+    return this->end_test(err);
+}
+
+/* the batch mode seeds each graph with the run seed and its index,
+ * so the results do not depend on the number of threads */
+template <typename F>
+bool Solver_test<F>::test_batch_seed()
+{
+    cout << "batch mode seed: ";
+    int err = 0;
+
+    char fname[] = "/tmp/digraph-batch-XXXXXX";
+    const int fd = mkstemp(fname);
+    if (fd == -1)
+        return this->end_test(1);
+
+    string stream;
+    for (int i = 0; i < 1 + this->tests / 10; i++)
+        stream += digraph6(this->random_graph()) + "\n";
+    if (write(fd, stream.data(), stream.size()) != (long) stream.size())
+        err++;
+    close(fd);
+
+    const int threads = omp_get_max_threads();
+    for (const bool decide : { false, true })
+    {
+        Run_options opt;
+        opt.decide = decide;
+        opt.seed = global::randgen();
+
+        string out[2];
+        for (int t = 0; t < 2; t++)
+        {
+            omp_set_num_threads((t == 0) ? 1 : 4);
+            stringstream ss;
+            streambuf *old = cout.rdbuf(ss.rdbuf());
+            const bool output = global::output;
+            global::output = false;
+            util::solve_batch<F>({ fname }, opt);
+            global::output = output;
+            cout.rdbuf(old);
+            out[t] = ss.str();
+        }
+        if (out[0].empty() || out[0] != out[1])
+            err++;
+    }
+    omp_set_num_threads(threads);
+    unlink(fname);
+
+    return this->end_test(err);
+}
+
+template class Solver_test<GF2_16>;
+template class Solver_test<GF2_32>;
+template class Solver_test<GF2_generic>;
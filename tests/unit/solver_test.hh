@@ -2,14 +2,33 @@
 #ifndef SOLVER_TEST_H
 #define SOLVER_TEST_H
 
+#include <vector>
+
 #include "test.hh"
 
+template <typename F>
 class Solver_test : public Test
 {
 private:
     int n = 5;
 
     bool test_solver();
+    bool test_decision();
+    bool test_components();
+    bool test_brute();
+    bool test_brute_long_cycle();
+    bool test_batch();
+    bool test_batch_seed();
+
+    std::vector<std::vector<int>> random_graph();
+
+    /* plain recursive search through all cycles */
+    int brute_reference(const std::vector<std::vector<int>> &adj,
+                        const int start,
+                        const int v,
+                        const int depth,
+                        std::vector<bool> &visited,
+                        int len);
 
 public:
     using Test::Test;
@@ -19,7 +38,9 @@ public:
         if (deg)
             this->n = deg;
         this->start_tests("solver");
-        return test_solver();
+        return test_solver() | test_decision() | test_components()
+            | test_brute() | test_brute_long_cycle() | test_batch()
+            | test_batch_seed();
     }
 };
 
@@ -16,13 +16,66 @@
 #include "ematrix_test.hh"
 #include "geng_test.hh"
 
-util::rand64bit global::randgen;
+thread_local util::rand64bit global::randgen;
 GR4_n *global::E;
 GF2_n *global::F;
 bool global::output = false;
 
 using namespace std;
 
+/* the tests of the options over the field F, the fields are set in main */
+template <typename F>
+static bool run_tests(const bool et,
+                      const bool gft,
+                      const bool fmt,
+                      const bool emt,
+                      const bool ut,
+                      const bool st,
+                      const bool geng,
+                      const int dim,
+                      const int tests)
+{
+    bool failure = false;
+
+    if (et)
+    {
+        GR_test<typename F::Ring> e(tests);
+        failure |= e.run();
+    }
+    if (gft)
+    {
+        GF_test<F> f;
+        failure |= f.run();
+    }
+    if (fmt)
+    {
+        FMatrix_test<F> fm(tests);
+        failure |= fm.run(dim);
+    }
+    if (ut)
+    {
+        Util_test<F> u(tests);
+        failure |= u.run(dim);
+    }
+    if (st)
+    {
+        Solver_test<F> s(tests);
+        failure |= s.run(dim);
+    }
+    if (emt)
+    {
+        EMatrix_test<F> em(tests);
+        failure |= em.run();
+    }
+    if (geng)
+    {
+        Geng_test<F> g;
+        failure |= g.run();
+    }
+
+    return failure;
+}
+
 int main(int argc, char** argv)
 {
     if (argc == 1 || (argc == 2 && strcmp(argv[1], "--help") == 0))
@@ -36,7 +89,7 @@ int main(int argc, char** argv)
         cout << " -x\t execute matrix tests with extension ring elements" << endl;
         cout << " -u\t execute utility functionality tests" << endl;
         cout << " -s\t execute solver tests" << endl;
-        cout << " -c\t run geng tests. example pipe command: \"geng -q $n | directg -q | listg -aq | ./digraph-tests -c -n 16\"" << endl;
+        cout << " -c\t run geng tests on digraph6, graph6 or listg -a input from stdin. example pipe command: \"geng -q $n | directg -q | ./digraph-tests -c -n 16\"" << endl;
         cout << " -d\t dimension of square matrices for matrix tests" << endl;
         cout << " -n\t exponent for the underlying finite field with 3 <= n <= 32. optimized for n=16 or n=32." << endl;
         cout << " -t\t number of repeats for tests" << endl;
@@ -100,7 +153,7 @@ int main(int argc, char** argv)
     }
 
     cout << "seed: " << seed << endl;
-    global::randgen.init(seed);
+    global::randgen.init_all(seed);
 
     if (n > 32 || n < 3)
     {
@@ -115,15 +168,15 @@ int main(int argc, char** argv)
     {
     case 16:
         /* x^16 + x^5 + x^3 + x^2 +  1 */
-        mod = 0x1002D;
-        global::F = new GF2_16(16, mod);
-        global::E = new GR4_16(16, mod);
+        mod = GF2_16::get_mod();
+        global::F = new GF2_n(16, mod);
+        global::E = new GR4_n(16, mod);
         break;
     case 32:
         /* x^32 + x^7 + x^3 + x^2 + 1 */
-        mod = 0x10000008D;
-        global::F = new GF2_32(32, mod);
-        global::E = new GR4_32(32, mod);
+        mod = GF2_32::get_mod();
+        global::F = new GF2_n(32, mod);
+        global::E = new GR4_n(32, mod);
         break;
     default:
         mod = util::irred_poly(n);
@@ -132,43 +185,14 @@ int main(int argc, char** argv)
         break;
     }
 
-    bool failure = false;
-
-    if (et)
-    {
-        GR_test e(tests);
-        failure |= e.run();
-    }
-    if (gft)
-    {
-        GF_test f;
-        failure |= f.run();
-    }
-    if (fmt)
-    {
-        FMatrix_test fm(tests);
-        failure |= fm.run(dim);
-    }
-    if (ut)
-    {
-        Util_test u(tests);
-        failure |= u.run(dim);
-    }
-    if (st)
-    {
-        Solver_test s(tests);
-        failure |= s.run(dim);
-    }
-    if (emt)
-    {
-        EMatrix_test em(tests);
-        failure |= em.run();
-    }
-    if (geng)
+    switch (n)
     {
-        Geng_test g;
-        failure |= g.run();
+    case 16:
+        return run_tests<GF2_16>(et, gft, fmt, emt, ut, st, geng, dim, tests);
+    case 32:
+        return run_tests<GF2_32>(et, gft, fmt, emt, ut, st, geng, dim, tests);
+    default:
+        return run_tests<GF2_generic>(et, gft, fmt, emt, ut, st, geng, dim,
+                                      tests);
     }
-
-    return failure;
 }
@@ -1,37 +1,44 @@
 /* Copyright 2022 Eetu Karppinen. Subject to the MIT license. */
 #include <iostream>
 #include <vector>
+#include <string>
+#include <set>
+#include <unistd.h>
+#include <omp.h>
 
 #include "util_test.hh"
 #include "../../src/gf.hh"
 #include "../../src/polynomial.hh"
 #include "../../src/util.hh"
+#include "../../src/csr.hh"
+#include "../../src/parser.hh"
 #include "../../src/global.hh"
 
 using namespace std;
 
-bool Util_test::test_interpolation()
+template <typename F>
+bool Util_test<F>::test_interpolation()
 {
     cout << "polynomial interpolation: ";
     int err = 0;
     for (int t = 0; t < this->tests; t++)
     {
-        uint64_t g = global::F->rem(global::randgen());
-        uint64_t d = global::F->rem(global::randgen());
+        uint64_t g = F::rem(global::randgen());
+        uint64_t d = F::rem(global::randgen());
 
-        vector<GF_element> gamma(n);
-        vector<GF_element> delta(n);
+        vector<GF_element<F>> gamma(n);
+        vector<GF_element<F>> delta(n);
 
         for (int i = 0; i < n; i++)
         {
-            gamma[i] = GF_element(g);
-            g = global::F->rem(g + 1);
+            gamma[i] = GF_element<F>(g);
+            g = F::rem(g + 1);
 
-            delta[i] = GF_element(d);
-            d = global::F->rem(d + 1);
+            delta[i] = GF_element<F>(d);
+            d = F::rem(d + 1);
         }
 
-        Polynomial p = util::poly_interpolation(gamma, delta);
+        Polynomial<F> p = util::poly_interpolation(gamma, delta);
 
         for (int i = 0; i < n; i++)
         {
@@ -45,7 +52,8 @@ bool Util_test::test_interpolation()
     return this->end_test(err);
 }
 
-bool Util_test::test_log2()
+template <typename F>
+bool Util_test<F>::test_log2()
 {
     cout << "log2: ";
     int err = 0;
@@ -59,3 +67,554 @@ bool Util_test::test_log2()
     }
     return this->end_test(err);
 }
+
+template <typename F>
+Polynomial<F> Util_test<F>::random_poly(const int deg)
+{
+    Polynomial<F> p(deg);
+    for (int i = 0; i <= deg; i++)
+        p(i, util::GF_random<F>());
+    return p;
+}
+
+template <typename F>
+int Util_test<F>::points(const int m)
+{
+    return min<uint64_t>(m, 1ull << F::get_n());
+}
+
+/* the degrees are large enough for karatsuba and newton division */
+template <typename F>
+bool Util_test<F>::test_poly_mul()
+{
+    cout << "polynomial multiplication: ";
+    int err = 0;
+    for (int t = 0; t < this->tests / 10; t++)
+    {
+        const Polynomial<F> a = this->random_poly(global::randgen() % 300);
+        const Polynomial<F> b = this->random_poly(global::randgen() % 300);
+        const Polynomial<F> prod = a * b;
+
+        Polynomial<F> ref(a.get_deg() + b.get_deg());
+        for (int i = 0; i <= a.get_deg(); i++)
+            for (int j = 0; j <= b.get_deg(); j++)
+                ref(i + j, ref[i + j] + a[i] * b[j]);
+
+        for (int i = 0; i <= ref.get_deg(); i++)
+        {
+            if (prod.get_deg() != ref.get_deg() || prod[i] != ref[i])
+            {
+                err++;
+                break;
+            }
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool Util_test<F>::test_poly_rem()
+{
+    cout << "polynomial remainder: ";
+    int err = 0;
+    for (int t = 0; t < this->tests / 10; t++)
+    {
+        Polynomial<F> m = this->random_poly(1 + global::randgen() % 200);
+        m(m.get_deg(), util::GF_one<F>());
+        const Polynomial<F> q = this->random_poly(global::randgen() % 200);
+        const Polynomial<F> r = this->random_poly(m.get_deg() - 1);
+
+        /* a = q*m + r */
+        Polynomial<F> a = q * m;
+        for (int i = 0; i <= r.get_deg(); i++)
+            a(i, a[i] + r[i]);
+
+        const Polynomial<F> rem = a % m;
+        if (rem.get_deg() != r.get_deg())
+        {
+            err++;
+            continue;
+        }
+        for (int i = 0; i <= r.get_deg(); i++)
+        {
+            if (rem[i] != r[i])
+            {
+                err++;
+                break;
+            }
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool Util_test<F>::test_multipoint_eval()
+{
+    cout << "multipoint evaluation: ";
+    int err = 0;
+    for (int t = 0; t < this->tests / 100; t++)
+    {
+        const int n = 1 + global::randgen() % this->points(300);
+        const vector<GF_element<F>> gamma = util::distinct_elements<F>(n);
+        const Polynomial<F> p = this->random_poly(global::randgen() % 400);
+
+        const vector<GF_element<F>> values =
+            Subproduct_tree<F>(gamma).evaluate(p);
+        for (int i = 0; i < n; i++)
+        {
+            if (values[i] != p.eval(gamma[i]))
+            {
+                err++;
+                break;
+            }
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool Util_test<F>::test_fast_interpolation()
+{
+    cout << "subproduct tree interpolation: ";
+    int err = 0;
+    for (int t = 0; t < this->tests / 100; t++)
+    {
+        const int n = 2 + global::randgen() % (this->points(302) - 1);
+        const vector<GF_element<F>> gamma = util::distinct_elements<F>(n);
+        vector<GF_element<F>> delta(n);
+        for (int i = 0; i < n; i++)
+            delta[i] = util::GF_random<F>();
+
+        const Polynomial<F> p = Subproduct_tree<F>(gamma).interpolate(delta);
+        const Polynomial<F> ref =
+            util::poly_interpolation_lagrange(gamma, delta);
+        for (int i = 0; i < n; i++)
+        {
+            if (p[i] != ref[i])
+            {
+                err++;
+                break;
+            }
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool Util_test<F>::test_additive_fft()
+{
+    cout << "additive fft: ";
+    int err = 0;
+    for (int t = 0; t < this->tests / 100; t++)
+    {
+        const int k = global::randgen() % min(10, F::get_n() + 1);
+        const Additive_FFT<F> fft(k);
+        const vector<GF_element<F>> gamma = util::subspace_elements<F>(1 << k);
+
+        const Polynomial<F> p = this->random_poly((1 << k) - 1);
+        const vector<GF_element<F>> values = fft.evaluate(p);
+        for (int i = 0; i < (1 << k); i++)
+        {
+            if (values[i] != p.eval(gamma[i]))
+            {
+                err++;
+                break;
+            }
+        }
+
+        /* interpolation at the first m points */
+        const int m = 1 + global::randgen() % (1 << k);
+        const vector<GF_element<F>> delta(values.begin(), values.begin() + m);
+        const vector<GF_element<F>> points(gamma.begin(), gamma.begin() + m);
+        const Polynomial<F> q = fft.interpolate(delta);
+        const Polynomial<F> ref =
+            util::poly_interpolation_lagrange(points, delta);
+        for (int i = 0; i < m; i++)
+        {
+            if (q[i] != ref[i])
+            {
+                err++;
+                break;
+            }
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool Util_test<F>::test_interpolation_plan()
+{
+    cout << "interpolation plan: ";
+    int err = 0;
+    for (int t = 0; t < this->tests / 100; t++)
+    {
+        const int n = 2 + global::randgen() % (this->points(152) - 1);
+        const Interpolation_mode mode =
+            (t % 2) ? RANDOM_POINTS : SUBSPACE_POINTS;
+        const Interpolation_plan<F> plan(n, mode);
+
+        /* the same plan for several interpolations */
+        for (int r = 0; r < 3; r++)
+        {
+            vector<GF_element<F>> delta(n);
+            for (int i = 0; i < n; i++)
+                delta[i] = util::GF_random<F>();
+
+            const Polynomial<F> p = plan.interpolate(delta);
+            const Polynomial<F> ref =
+                util::poly_interpolation_lagrange(plan.get_points(), delta);
+            for (int i = 0; i < n; i++)
+            {
+                if (p[i] != ref[i])
+                {
+                    err++;
+                    break;
+                }
+            }
+        }
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool Util_test<F>::test_direct_undirected()
+{
+    cout << "direct undirected graph: ";
+    int err = 0;
+    for (int t = 0; t < this->tests / 10; t++)
+    {
+        const int n = 1 + global::randgen() % 30;
+        vector<vector<bool>> edge(n, vector<bool>(n, false));
+        vector<vector<int>> adj(n);
+        for (int u = 0; u < n; u++)
+        {
+            for (int v = u + 1; v < n; v++)
+            {
+                if (global::randgen() % 3 == 0)
+                {
+                    edge[u][v] = edge[v][u] = true;
+                    adj[u].push_back(v);
+                    adj[v].push_back(u);
+                }
+            }
+        }
+
+        /* exactly one of u->v and v->u for each edge */
+        const CSR directed = util::direct_undirected(CSR(adj));
+        vector<vector<int>> arcs(n, vector<int>(n, 0));
+        for (int u = 0; u < n; u++)
+            for (const int *v = directed.begin(u); v != directed.end(u); v++)
+                arcs[u][*v]++;
+
+        for (int u = 0; u < n; u++)
+            for (int v = u + 1; v < n; v++)
+                if (arcs[u][v] + arcs[v][u] != (int) edge[u][v])
+                    err++;
+    }
+    return this->end_test(err);
+}
+
+template <typename F>
+bool Util_test<F>::test_parse_graph()
+{
+    cout << "parse graph file: ";
+    int err = 0;
+    string error;
+    for (int t = 0; t < this->tests / 10; t++)
+    {
+        const int n = 1 + global::randgen() % 40;
+        vector<vector<int>> adj(n);
+        string text;
+        for (int u = 0; u < n; u++)
+        {
+            if (global::randgen() % 4 == 0)
+                text += "# comment 1 2\n";
+            const int d = global::randgen() % 6;
+            for (int i = 0; i < d; i++)
+            {
+                adj[u].push_back(global::randgen() % n);
+                text += (global::randgen() % 2 ? "  " : "\t")
+                    + to_string(adj[u].back());
+            }
+            text += (global::randgen() % 3 == 0) ? "\r\n" : "\n";
+        }
+        /* no newline at the end of a nonempty line */
+        if (!adj[n - 1].empty() && global::randgen() % 2)
+            text.pop_back();
+
+        /* the chunks have to agree with one thread */
+        const CSR expected(adj);
+        for (int chunks = 1; chunks <= 5; chunks += 2)
+        {
+            CSR parsed;
+            if (!util::parse_graph(text.data(), text.data() + text.size(),
+                                   parsed, error, chunks)
+                || parsed.offsets != expected.offsets
+                || parsed.targets != expected.targets)
+                err++;
+        }
+    }
+
+    /* invalid ids and characters */
+    const vector<string> invalid = {
+        "1\n2\n", "0 -1\n", "0 x\n", "# 5\n0 1\n", "99999999999\n"
+    };
+    for (const string &text : invalid)
+    {
+        CSR parsed;
+        if (util::parse_graph(text.data(), text.data() + text.size(),
+                              parsed, error, 2))
+            err++;
+    }
+
+    return this->end_test(err);
+}
+
+template <typename F>
+bool Util_test<F>::test_graph_formats()
+{
+    cout << "graph file formats: ";
+    int err = 0;
+    string error;
+    for (int t = 0; t < this->tests / 10; t++)
+    {
+        /* simple digraph, digraph6 has the arcs in order */
+        const int n = 1 + global::randgen() % 70;
+        vector<vector<int>> adj(n);
+        string edges = "% edge list\n";
+        string d6 = "&";
+        if (n < 63)
+        {
+            d6 += (char) (63 + n);
+        }
+        else
+        {
+            d6 += (char) 126;
+            for (int s = 12; s >= 0; s -= 6)
+                d6 += (char) (63 + ((n >> s) & 63));
+        }
+        int bits = 0;
+        int k = 0;
+        for (int u = 0; u < n; u++)
+        {
+            for (int v = 0; v < n; v++)
+            {
+                const bool arc = global::randgen() % 4 == 0;
+                if (arc)
+                {
+                    adj[u].push_back(v);
+                    edges += to_string(u) + " " + to_string(v) + "\n";
+                }
+                bits = (bits << 1) | arc;
+                if (++k % 6 == 0)
+                {
+                    d6 += (char) (63 + bits);
+                    bits = 0;
+                }
+            }
+        }
+        if (k % 6)
+            d6 += (char) (63 + (bits << (6 - k % 6)));
+        d6 += "\n";
+
+        const CSR expected(adj);
+        auto same = [&](const CSR &parsed)
+        {
+            return parsed.offsets == expected.offsets
+                && parsed.targets == expected.targets;
+        };
+
+        CSR parsed;
+        if (!util::parse_digraph6(d6.data(), d6.data() + d6.size(),
+                                  parsed, error) || !same(parsed))
+            err++;
+
+        if (util::detect_format(d6.data(), d6.data() + d6.size()) != DIGRAPH6)
+            err++;
+
+        /* the edge list leaves out the isolated vertices at the end */
+        if (!adj.back().empty()
+            && (!util::parse_edge_list(edges.data(),
+                                       edges.data() + edges.size(),
+                                       parsed, error) || !same(parsed)))
+            err++;
+
+        vector<char> bin = util::to_binary(expected);
+        if (!util::parse_binary(bin.data(), bin.data() + bin.size(),
+                                parsed, error) || !same(parsed))
+            err++;
+
+        /* corruption is caught by the checksum */
+        const int arrays = bin.size() - sizeof(Binary_header);
+        bin[sizeof(Binary_header) + global::randgen() % arrays] ^= 0x10;
+        if (util::parse_binary(bin.data(), bin.data() + bin.size(),
+                               parsed, error))
+            err++;
+    }
+
+    return this->end_test(err);
+}
+
+template <typename F>
+bool Util_test<F>::test_undirected_formats()
+{
+    cout << "graph6 and DIMACS: ";
+    int err = 0;
+    string error;
+    for (int t = 0; t < this->tests / 10; t++)
+    {
+        const int n = 2 + global::randgen() % 70;
+        vector<set<int>> edges(n);
+        string dimacs = "c undirected\np edge " + to_string(n) + " 0\n";
+        string g6;
+        if (n < 63)
+        {
+            g6 += (char) (63 + n);
+        }
+        else
+        {
+            g6 += (char) 126;
+            for (int s = 12; s >= 0; s -= 6)
+                g6 += (char) (63 + ((n >> s) & 63));
+        }
+
+        /* upper triangle column by column */
+        int bits = 0;
+        int k = 0;
+        for (int v = 1; v < n; v++)
+        {
+            for (int u = 0; u < v; u++)
+            {
+                const bool edge = global::randgen() % 3 == 0;
+                if (edge)
+                {
+                    edges[u].insert(v);
+                    edges[v].insert(u);
+                    dimacs += "e " + to_string(u + 1) + " "
+                        + to_string(v + 1) + "\n";
+                }
+                bits = (bits << 1) | edge;
+                if (++k % 6 == 0)
+                {
+                    g6 += (char) (63 + bits);
+                    bits = 0;
+                }
+            }
+        }
+        if (k % 6)
+            g6 += (char) (63 + (bits << (6 - k % 6)));
+
+        auto same = [&](const CSR &parsed)
+        {
+            if (parsed.get_n() != n)
+                return false;
+            for (int u = 0; u < n; u++)
+                if (set<int>(parsed.begin(u), parsed.end(u)) != edges[u]
+                    || parsed.degree(u) != (int) edges[u].size())
+                    return false;
+            return true;
+        };
+
+        CSR parsed;
+        if (!util::parse_graph6(g6.data(), g6.data() + g6.size(),
+                                parsed, error) || !same(parsed))
+            err++;
+        if (util::detect_format(g6.data(), g6.data() + g6.size()) != GRAPH6)
+            err++;
+
+        if (!util::parse_dimacs(dimacs.data(), dimacs.data() + dimacs.size(),
+                                parsed, error) || !same(parsed))
+            err++;
+        if (util::detect_format(dimacs.data(), dimacs.data() + dimacs.size())
+            != DIMACS)
+            err++;
+
+        /* a stream of graph6 lines through a pipe */
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            err++;
+            continue;
+        }
+        const string stream = g6 + "\n" + g6 + "\n";
+        if (write(fds[1], stream.data(), stream.size()) != (long) stream.size())
+            err++;
+        close(fds[1]);
+
+        Graph_reader reader(fds[0]);
+        int graphs = 0;
+        while (reader.next(parsed))
+        {
+            graphs++;
+            if (!same(parsed))
+                err++;
+        }
+        close(fds[0]);
+        if (graphs != 2 || !reader.get_error().empty())
+            err++;
+    }
+
+    /* arcs of the shortest path format are one way */
+    const string arcs = "p sp 3 2\na 1 2 7\na 3 1 1\n";
+    CSR parsed;
+    if (!util::parse_dimacs(arcs.data(), arcs.data() + arcs.size(),
+                            parsed, error)
+        || parsed.offsets != vector<int>({ 0, 1, 1, 2 })
+        || parsed.targets != vector<int>({ 1, 0 }))
+        err++;
+
+    /* the vertex count of the header is not allocated blindly */
+    const string huge = "p edge 300000000 1\ne 1 2\n";
+    if (util::parse_dimacs(huge.data(), huge.data() + huge.size(),
+                           parsed, error))
+        err++;
+
+    /* listg -a matrices */
+    int fds[2];
+    if (pipe(fds) == 0)
+    {
+        const string stream = "3\n010\n001\n100\n\n2\n01\n10\n";
+        if (write(fds[1], stream.data(), stream.size()) != (long) stream.size())
+            err++;
+        close(fds[1]);
+
+        Graph_reader reader(fds[0]);
+        if (!reader.next(parsed) || parsed.targets != vector<int>({ 1, 2, 0 }))
+            err++;
+        if (!reader.next(parsed) || parsed.targets != vector<int>({ 1, 0 }))
+            err++;
+        if (reader.next(parsed) || !reader.get_error().empty())
+            err++;
+        close(fds[0]);
+    }
+
+    return this->end_test(err);
+}
+
+/* the threads that did not call init draw different nonzero values */
+template <typename F>
+bool Util_test<F>::test_thread_randgen()
+{
+    cout << "thread generators: ";
+    int err = 0;
+    set<uint64_t> drawn;
+    unsigned int threads = 0;
+    #pragma omp parallel num_threads(4) shared(drawn, threads)
+    {
+        const uint64_t a = global::randgen();
+        const uint64_t b = global::randgen();
+        #pragma omp critical
+        {
+            drawn.insert(a);
+            drawn.insert(b);
+            threads++;
+        }
+    }
+    if (drawn.count(0) || drawn.size() != 2 * threads)
+        err++;
+    return this->end_test(err);
+}
+
+template class Util_test<GF2_16>;
+template class Util_test<GF2_32>;
+template class Util_test<GF2_generic>;
@@ -3,7 +3,9 @@
 #define UTIL_TEST_H
 
 #include "test.hh"
+#include "../../src/polynomial.hh"
 
+template <typename F>
 class Util_test : public Test
 {
 private:
@@ -11,6 +13,21 @@ private:
 
     bool test_interpolation();
     bool test_log2();
+    bool test_poly_mul();
+    bool test_poly_rem();
+    bool test_multipoint_eval();
+    bool test_fast_interpolation();
+    bool test_additive_fft();
+    bool test_interpolation_plan();
+    bool test_direct_undirected();
+    bool test_parse_graph();
+    bool test_graph_formats();
+    bool test_undirected_formats();
+    bool test_thread_randgen();
+
+    Polynomial<F> random_poly(const int deg);
+    /* m or the 2^n elements of the field if there are fewer */
+    int points(const int m);
 
 public:
     using Test::Test;
@@ -21,7 +38,12 @@ public:
             this->n = deg;
         this->start_tests("util");
 
-        return test_interpolation() | test_log2();
+        return test_interpolation() | test_log2() | test_poly_mul()
+            | test_poly_rem() | test_multipoint_eval()
+            | test_fast_interpolation() | test_additive_fft()
+            | test_interpolation_plan() | test_direct_undirected()
+            | test_parse_graph() | test_graph_formats()
+            | test_undirected_formats() | test_thread_randgen();
     }
 };
 